@@ -4,13 +4,49 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
-../Sources/main.c 
+../Sources/arena.c \
+../Sources/autopilot.c \
+../Sources/display.c \
+../Sources/frame.c \
+../Sources/governor.c \
+../Sources/hamilton_table.c \
+../Sources/level_table.c \
+../Sources/main.c \
+../Sources/power.c \
+../Sources/replay.c \
+../Sources/snake.c \
+../Sources/viewport.c \
+../Sources/wheel.c 
 
 OBJS += \
-./Sources/main.o 
+./Sources/arena.o \
+./Sources/autopilot.o \
+./Sources/display.o \
+./Sources/frame.o \
+./Sources/governor.o \
+./Sources/hamilton_table.o \
+./Sources/level_table.o \
+./Sources/main.o \
+./Sources/power.o \
+./Sources/replay.o \
+./Sources/snake.o \
+./Sources/viewport.o \
+./Sources/wheel.o 
 
 C_DEPS += \
-./Sources/main.d 
+./Sources/arena.d \
+./Sources/autopilot.d \
+./Sources/display.d \
+./Sources/frame.d \
+./Sources/governor.d \
+./Sources/hamilton_table.d \
+./Sources/level_table.d \
+./Sources/main.d \
+./Sources/power.d \
+./Sources/replay.d \
+./Sources/snake.d \
+./Sources/viewport.d \
+./Sources/wheel.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -0,0 +1,219 @@
+/*
+ * Several snakes on one board. Checks every tick of update_arena() against
+ * a reference that looks for collisions by walking every body, then times
+ * the tick for growing numbers of snakes.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "check.h"
+#include "play.h"
+#include "tools.h"
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n TICKS   ticks to check and to time for every number of snakes (default 200000)\n",
+		prog);
+	exit(2);
+}
+
+static unsigned int segment(const Rival *r, unsigned int i) {
+	return r->body[(r->head + SNAKE_MAX_LENGTH - i) % SNAKE_MAX_LENGTH];
+}
+
+/* Greedy turn toward the food that avoids the bodies, the arena version of greedy_steer() */
+static Direction steer(const Arena *a, unsigned int i, uint32_t r) {
+	static const Direction turns[4] = { RIGHT, DOWN, UP, LEFT };
+	const Rival *s = &a->snakes[i];
+	unsigned int head = segment(s, 0), tail = segment(s, s->length - 1);
+	int dr = axis_step(CELL_ROW(head), CELL_ROW(a->food), ROWS);
+	int dc = axis_step(CELL_COL(head), CELL_COL(a->food), COLS);
+	Direction best = s->dir;
+	int best_score = -1;
+
+	for (int k = 0; k < 4; k++) {
+		Direction d = turns[(k + r) % 4];
+		unsigned int target = cell_step(head, d);
+		int score;
+
+		if (d == opposite(s->moved) || target == CELLS ||
+			(arena_owner(a, target) != ARENA_NONE && target != tail)) {
+			continue;
+		}
+		score = (d == LEFT && dr > 0) || (d == RIGHT && dr < 0) || (d == DOWN && dc > 0) || (d == UP && dc < 0);
+		if (score > best_score) {
+			best_score = score;
+			best = d;
+		}
+	}
+	return best;
+}
+
+/* Snakes that crash on the next tick, found by comparing the targets with every body cell */
+static uint32_t reference_crashes(const Arena *a) {
+	unsigned int target[ARENA_SNAKES];
+	uint32_t crashed = 0;
+
+	for (unsigned int i = 0; i < a->n; i++) {
+		const Rival *r = &a->snakes[i];
+
+		target[i] = r->alive ? cell_step(segment(r, 0), r->dir) : CELLS;
+	}
+	for (unsigned int i = 0; i < a->n; i++) {
+		if (!a->snakes[i].alive) {
+			continue;
+		}
+		if (target[i] == CELLS) {
+			crashed |= 1u << i;
+		}
+		for (unsigned int j = 0; j < a->n; j++) {
+			const Rival *r = &a->snakes[j];
+
+			if (!r->alive) {
+				continue;
+			}
+			if (j != i && target[j] == target[i]) {
+				crashed |= 1u << i;
+			}
+			/* A tail moves away unless its snake eats */
+			unsigned int keep = target[j] == a->food ? r->length : r->length - 1u;
+
+			for (unsigned int k = 0; k < keep; k++) {
+				if (segment(r, k) == target[i]) {
+					crashed |= 1u << i;
+				}
+			}
+		}
+	}
+	return crashed;
+}
+
+/* Verify the shared board against the bodies, returns NULL or the first violation */
+static const char *check_arena(const Arena *a) {
+	static uint64_t seen[BOARD_WORDS];
+	uint32_t used = 0;
+	unsigned int alive = 0;
+
+	for (int w = 0; w < BOARD_WORDS; w++) {
+		seen[w] = 0;
+	}
+	for (unsigned int i = 0; i < a->n; i++) {
+		const Rival *r = &a->snakes[i];
+
+		if (!r->alive) {
+			continue;
+		}
+		alive++;
+		used += r->length;
+		for (unsigned int k = 0; k < r->length; k++) {
+			unsigned int cell = segment(r, k);
+
+			if ((seen[cell / 64] >> (cell % 64)) & 1) {
+				return "two segments on one cell";
+			}
+			seen[cell / 64] |= 1ull << (cell % 64);
+			if (arena_owner(a, cell) != i) {
+				return "owner map does not match the body";
+			}
+		}
+	}
+	for (int w = 0; w < BOARD_WORDS; w++) {
+		if (seen[w] != a->occupied[w]) {
+			return "occupancy bitboard does not match the bodies";
+		}
+	}
+	if (used != a->used || alive != a->alive) {
+		return "cell or snake count out of step";
+	}
+	if (a->state == PLAYING && arena_owner(a, a->food) != ARENA_NONE) {
+		return "food under a body";
+	}
+	return NULL;
+}
+
+int main(int argc, char *argv[]) {
+	uint64_t ticks = 200000;
+	uint32_t r = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+			case 'n': ticks = strtoull(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+
+	static Arena a;
+	const char *why;
+
+	printf("Board:        %dx%d, %s, %zu byte arena for up to %d snakes\n", COLS, ROWS,
+		SNAKE_WALLS ? "walls" : "wrapping", sizeof(Arena), ARENA_SNAKES);
+	printf("%7s %10s %10s %12s %14s\n", "snakes", "games", "crashes", "ns/tick", "ns/snake-step");
+
+	for (unsigned int n = 1; n <= ARENA_SNAKES; n *= 2) {
+		uint64_t games = 0, crashes = 0, steps = 0;
+
+		/* Every tick against the reference */
+		init_arena(&a, n, 1);
+		for (uint64_t t = 0; t < ticks; t++) {
+			for (unsigned int i = 0; i < n; i++) {
+				if (a.snakes[i].alive) {
+					steer_arena(&a, i, steer(&a, i, xorshift(&r)));
+				}
+			}
+
+			uint32_t before = 0, after = 0, want = reference_crashes(&a);
+
+			for (unsigned int i = 0; i < n; i++) {
+				before |= (uint32_t)a.snakes[i].alive << i;
+			}
+			update_arena(&a);
+			for (unsigned int i = 0; i < n; i++) {
+				after |= (uint32_t)a.snakes[i].alive << i;
+			}
+			if ((before & ~after) != want) {
+				printf("%u snakes, tick %" PRIu64 ": crashed %#x, reference %#x\n", n, t, before & ~after, want);
+				return 1;
+			}
+			crashes += __builtin_popcount(want);
+			if ((t % 256 == 0 || a.state != PLAYING) && (why = check_arena(&a))) {
+				printf("%u snakes, tick %" PRIu64 ": %s\n", n, t, why);
+				return 1;
+			}
+			if (a.state != PLAYING) {
+				games++;
+				init_arena(&a, n, xorshift(&r));
+			}
+		}
+
+		/* The same play timed, steering included */
+		struct timespec t0, t1;
+
+		init_arena(&a, n, 1);
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (uint64_t t = 0; t < ticks; t++) {
+			for (unsigned int i = 0; i < n; i++) {
+				if (a.snakes[i].alive) {
+					steer_arena(&a, i, steer(&a, i, xorshift(&r)));
+				}
+			}
+			steps += a.alive;
+			update_arena(&a);
+			if (a.state != PLAYING) {
+				init_arena(&a, n, xorshift(&r));
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		double elapsed = seconds(&t0, &t1);
+
+		printf("%7u %10" PRIu64 " %10" PRIu64 " %12.1f %14.1f\n", n, games, crashes, elapsed / ticks * 1e9,
+			elapsed / steps * 1e9);
+	}
+	return 0;
+}
@@ -0,0 +1,109 @@
+/* Worst-case running time of the attract mode autopilot against the game tick */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "autopilot.h"
+#include "check.h"
+#include "snake.h"
+
+/*
+ * Cortex-M4 cycle estimates, counted from the instructions rather than
+ * measured on the board. A flood fill layer is about 130 instructions of
+ * 32-bit shifts and masks over the two board words, a call adds the set up
+ * of the board and the turn probes. Cycles read from DWT_CYCCNT around
+ * autopilot_steer() on the board can replace them with -l and -c.
+ */
+#define LAYER_CYCLES 150
+#define CALL_CYCLES 400
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -g GAMES   demo games to play (default 10000)\n"
+		"  -t TICKS   tick limit per game (default 20000)\n"
+		"  -l CYCLES  cycles per flood fill layer (default %d)\n"
+		"  -c CYCLES  fixed cycles per call (default %d)\n"
+		"  -p LDVAL   PIT0 reload value, one tick of the timer wheel (default 4800)\n"
+		"  -k TICKS   wheel ticks per game tick (default 1000)\n"
+		"  -b DIV     core to bus clock divider (default 1)\n",
+		prog, LAYER_CYCLES, CALL_CYCLES);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int games = 10000, max_ticks = 20000, layer = LAYER_CYCLES, call = CALL_CYCLES;
+	unsigned int ldval = 4800, wheel_ticks = 1000, div = 1;
+	uint64_t calls = 0, layers = 0, worst = 0, worst_length = 0, won = 0, ticks = 0, length = 0;
+	uint64_t histogram[4 * CELLS + 1] = { 0 };
+	int opt;
+
+	while ((opt = getopt(argc, argv, "g:t:l:c:p:k:b:")) != -1) {
+		switch (opt) {
+			case 'g': games = strtoul(optarg, NULL, 0); break;
+			case 't': max_ticks = strtoul(optarg, NULL, 0); break;
+			case 'l': layer = strtoul(optarg, NULL, 0); break;
+			case 'c': call = strtoul(optarg, NULL, 0); break;
+			case 'p': ldval = strtoul(optarg, NULL, 0); break;
+			case 'k': wheel_ticks = strtoul(optarg, NULL, 0); break;
+			case 'b': div = strtoul(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+	if (!games || !wheel_ticks || !div) {
+		usage(argv[0]);
+	}
+
+	/* Play demo games the way the game tick does: steer, then step */
+	for (unsigned int g = 0; g < games; g++) {
+		Snake s;
+		const char *why;
+		unsigned int t;
+
+		init_snake(&s, 1 + g);
+		for (t = 0; t < max_ticks && s.state == PLAYING; t++) {
+			steer_snake(&s, autopilot_steer(&s));
+			calls++;
+			layers += autopilot_layers;
+			histogram[autopilot_layers <= 4 * CELLS ? autopilot_layers : 4 * CELLS]++;
+			if (autopilot_layers > worst) {
+				worst = autopilot_layers;
+				worst_length = s.length;
+			}
+
+			update_snake(&s);
+			if ((why = check_snake(&s))) {
+				fprintf(stderr, "game %u tick %u: %s\n", g, t, why);
+				return 1;
+			}
+		}
+		ticks += t;
+		length += s.length;
+		won += s.state == GAME_WON;
+	}
+
+	uint64_t p99 = 0, seen = 0;
+	for (unsigned int i = 0; i <= 4 * CELLS; i++) {
+		seen += histogram[i];
+		if (seen * 100 >= calls * 99) {
+			p99 = i;
+			break;
+		}
+	}
+
+	uint64_t tick = (uint64_t)(ldval + 1) * wheel_ticks * div;
+	uint64_t estimate = call + (uint64_t)4 * CELLS * layer;
+
+	printf("Demo games:   %u, %.1f ticks and final length %.1f mean, %" PRIu64 " won\n",
+		games, (double)ticks / games, (double)length / games, won);
+	printf("Layers/call:  %.1f mean, %" PRIu64 " at 99 %%, %" PRIu64 " worst seen (length %" PRIu64 "), %d bound\n",
+		(double)layers / calls, p99, worst, worst_length, 4 * CELLS);
+	printf("Cycles/call:  %" PRIu64 " worst seen, %" PRIu64 " at the layer bound, estimated at %u per layer and %u per call\n",
+		call + worst * layer, estimate, layer, call);
+	printf("Game tick:    %" PRIu64 " cycles, the estimate at the layer bound is %.2f %% of it\n", tick,
+		100.0 * estimate / tick);
+
+	return worst > 4 * CELLS || estimate * 10 > tick;
+}
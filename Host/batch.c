@@ -0,0 +1,458 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_X86 1
+#endif
+
+/* The kernels wrap with masks and step the ring with a mask */
+_Static_assert(ROWS == 8 && COLS == 16, "batch kernels assume the 16x8 matrix");
+_Static_assert(SNAKE_MAX_LENGTH == 128, "batch kernels assume a 128 cell ring");
+_Static_assert(PLAYING == 0 && STOP == 0, "batch kernels test state and dir against zero");
+
+/* Row and column steps per Direction, see snake_target() */
+static const int8_t step_row[16] = { 0, -1, 0, 0, 1 };
+static const int8_t step_col[16] = { 0, 0, 1, -1, 0 };
+
+/* One implementation of the vectorizable phases of a tick, over games [g, end) */
+typedef struct {
+	const char *name;
+	void (*targets)(Batch *b, unsigned int g, unsigned int end);
+	void (*boards)(Batch *b, unsigned int g, unsigned int end);
+	void (*commit)(Batch *b, unsigned int g, unsigned int end);
+} Kernels;
+
+/* Scalar kernels */
+
+/* Next head cell, eating and playing flags */
+static void targets_scalar(Batch *b, unsigned int g, unsigned int end) {
+	for (; g < end; g++) {
+		unsigned int row = (b->cell[g] + step_row[b->dir[g]]) & (ROWS - 1);
+		unsigned int col = ((b->cell[g] >> 3) + step_col[b->dir[g]]) & (COLS - 1);
+		uint8_t active = (b->state[g] == PLAYING && b->dir[g] != STOP) ? 0xFF : 0;
+
+		b->target[g] = CELL(row, col);
+		b->active[g] = active;
+		b->grow[g] = (b->target[g] == b->food[g]) ? active : 0;
+	}
+}
+
+/* Move the tail and head bits, flag the games whose head hits the body */
+static void boards_scalar(Batch *b, unsigned int g, unsigned int end) {
+	for (; g < end; g++) {
+		uint64_t keep = (uint64_t)0 - (b->grow[g] & 1), moves = (uint64_t)0 - (b->active[g] & 1);
+		uint64_t cleared[BOARD_WORDS], head[BOARD_WORDS], hit = 0;
+
+		for (unsigned int w = 0; w < BOARD_WORDS; w++) {
+			uint64_t tail = (uint64_t)(b->tail[g] >> 6 == w) << (b->tail[g] & 63);
+
+			head[w] = (uint64_t)(b->target[g] >> 6 == w) << (b->target[g] & 63);
+			cleared[w] = b->occupied[w][g] & ~(tail & ~keep);
+			hit |= cleared[w] & head[w];
+		}
+
+		/* Only a game that moves without crashing takes the new board */
+		moves &= (uint64_t)0 - !hit;
+		for (unsigned int w = 0; w < BOARD_WORDS; w++) {
+			b->occupied[w][g] = (b->occupied[w][g] & ~moves) | ((cleared[w] | head[w]) & moves);
+		}
+		b->hit[g] = hit ? b->active[g] : 0;
+	}
+}
+
+/* Advance head, direction and length of the games that moved, end the ones that crashed */
+static void commit_scalar(Batch *b, unsigned int g, unsigned int end) {
+	for (; g < end; g++) {
+		if (b->hit[g]) {
+			b->state[g] = GAME_OVER;
+		} else if (b->active[g]) {
+			b->cell[g] = b->target[g];
+			b->moved[g] = b->dir[g];
+			b->head[g] = (b->head[g] + 1) & (SNAKE_MAX_LENGTH - 1);
+			b->length[g] += b->grow[g] & 1;
+		}
+	}
+}
+
+#ifdef BATCH_X86
+
+/* SSSE3 kernels, 16 games per vector, bitboards stay scalar */
+
+__attribute__((target("ssse3")))
+static void targets_ssse3(Batch *b, unsigned int g, unsigned int end) {
+	const __m128i rows = _mm_set1_epi8(ROWS - 1), cols = _mm_set1_epi8(COLS - 1);
+	const __m128i dr = _mm_loadu_si128((const __m128i *)step_row);
+	const __m128i dc = _mm_loadu_si128((const __m128i *)step_col);
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; g < end; g += 16) {
+		__m128i cell = _mm_load_si128((const __m128i *)(b->cell + g));
+		__m128i dir = _mm_load_si128((const __m128i *)(b->dir + g));
+		__m128i row = _mm_and_si128(_mm_add_epi8(cell, _mm_shuffle_epi8(dr, dir)), rows);
+		__m128i col = _mm_and_si128(_mm_srli_epi16(cell, 3), cols);
+		col = _mm_and_si128(_mm_add_epi8(col, _mm_shuffle_epi8(dc, dir)), cols);
+
+		/* CELL(row, col) = col * 8 + row, the shift cannot carry across bytes after the mask */
+		__m128i target = _mm_or_si128(_mm_slli_epi16(col, 3), row);
+		__m128i active = _mm_andnot_si128(_mm_cmpeq_epi8(dir, zero),
+			_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)(b->state + g)), zero));
+		__m128i grow = _mm_and_si128(active,
+			_mm_cmpeq_epi8(target, _mm_load_si128((const __m128i *)(b->food + g))));
+
+		_mm_store_si128((__m128i *)(b->target + g), target);
+		_mm_store_si128((__m128i *)(b->active + g), active);
+		_mm_store_si128((__m128i *)(b->grow + g), grow);
+	}
+}
+
+static inline __m128i select_ssse3(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+__attribute__((target("ssse3")))
+static void commit_ssse3(Batch *b, unsigned int g, unsigned int end) {
+	const __m128i one = _mm_set1_epi8(1), ring = _mm_set1_epi8(SNAKE_MAX_LENGTH - 1);
+
+	for (; g < end; g += 16) {
+		__m128i hit = _mm_load_si128((const __m128i *)(b->hit + g));
+		__m128i moves = _mm_andnot_si128(hit, _mm_load_si128((const __m128i *)(b->active + g)));
+		__m128i grow = _mm_load_si128((const __m128i *)(b->grow + g));
+		__m128i head = _mm_load_si128((const __m128i *)(b->head + g));
+		__m128i length = _mm_load_si128((const __m128i *)(b->length + g));
+
+		head = select_ssse3(moves, _mm_and_si128(_mm_add_epi8(head, one), ring), head);
+		length = _mm_add_epi8(length, _mm_and_si128(_mm_and_si128(moves, grow), one));
+
+		_mm_store_si128((__m128i *)(b->cell + g), select_ssse3(moves,
+			_mm_load_si128((const __m128i *)(b->target + g)), _mm_load_si128((const __m128i *)(b->cell + g))));
+		_mm_store_si128((__m128i *)(b->moved + g), select_ssse3(moves,
+			_mm_load_si128((const __m128i *)(b->dir + g)), _mm_load_si128((const __m128i *)(b->moved + g))));
+		_mm_store_si128((__m128i *)(b->state + g), _mm_or_si128(
+			_mm_load_si128((const __m128i *)(b->state + g)), _mm_and_si128(hit, _mm_set1_epi8(GAME_OVER))));
+		_mm_store_si128((__m128i *)(b->head + g), head);
+		_mm_store_si128((__m128i *)(b->length + g), length);
+	}
+}
+
+/* AVX2 kernels, 32 games per byte vector and 4 per bitboard vector */
+
+__attribute__((target("avx2")))
+static void targets_avx2(Batch *b, unsigned int g, unsigned int end) {
+	const __m256i rows = _mm256_set1_epi8(ROWS - 1), cols = _mm256_set1_epi8(COLS - 1);
+	const __m256i dr = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)step_row));
+	const __m256i dc = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)step_col));
+	const __m256i zero = _mm256_setzero_si256();
+
+	for (; g < end; g += 32) {
+		__m256i cell = _mm256_load_si256((const __m256i *)(b->cell + g));
+		__m256i dir = _mm256_load_si256((const __m256i *)(b->dir + g));
+		__m256i row = _mm256_and_si256(_mm256_add_epi8(cell, _mm256_shuffle_epi8(dr, dir)), rows);
+		__m256i col = _mm256_and_si256(_mm256_srli_epi16(cell, 3), cols);
+		col = _mm256_and_si256(_mm256_add_epi8(col, _mm256_shuffle_epi8(dc, dir)), cols);
+
+		__m256i target = _mm256_or_si256(_mm256_slli_epi16(col, 3), row);
+		__m256i active = _mm256_andnot_si256(_mm256_cmpeq_epi8(dir, zero),
+			_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)(b->state + g)), zero));
+		__m256i grow = _mm256_and_si256(active,
+			_mm256_cmpeq_epi8(target, _mm256_load_si256((const __m256i *)(b->food + g))));
+
+		_mm256_store_si256((__m256i *)(b->target + g), target);
+		_mm256_store_si256((__m256i *)(b->active + g), active);
+		_mm256_store_si256((__m256i *)(b->grow + g), grow);
+	}
+}
+
+/* Widen four consecutive byte lanes to 64 bits */
+__attribute__((target("avx2")))
+static inline __m256i widen_avx2(const uint8_t *p) {
+	int32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(v));
+}
+
+__attribute__((target("avx2")))
+static void boards_avx2(Batch *b, unsigned int g, unsigned int end) {
+	const __m256i one = _mm256_set1_epi64x(1), low = _mm256_set1_epi64x(63), zero = _mm256_setzero_si256();
+
+	for (; g < end; g += 4) {
+		__m256i target = widen_avx2(b->target + g), tail = widen_avx2(b->tail + g);
+		__m256i grow = _mm256_cmpgt_epi64(widen_avx2(b->grow + g), zero);
+		__m256i active = _mm256_cmpgt_epi64(widen_avx2(b->active + g), zero);
+		__m256i target_bit = _mm256_sllv_epi64(one, _mm256_and_si256(target, low));
+		__m256i tail_bit = _mm256_andnot_si256(grow, _mm256_sllv_epi64(one, _mm256_and_si256(tail, low)));
+		__m256i target_word = _mm256_srli_epi64(target, 6), tail_word = _mm256_srli_epi64(tail, 6);
+		__m256i occupied[BOARD_WORDS], cleared[BOARD_WORDS], head[BOARD_WORDS], hit = zero;
+
+		for (int w = 0; w < BOARD_WORDS; w++) {
+			__m256i word = _mm256_set1_epi64x(w);
+
+			occupied[w] = _mm256_load_si256((const __m256i *)(b->occupied[w] + g));
+			head[w] = _mm256_and_si256(_mm256_cmpeq_epi64(target_word, word), target_bit);
+			cleared[w] = _mm256_andnot_si256(_mm256_and_si256(_mm256_cmpeq_epi64(tail_word, word), tail_bit), occupied[w]);
+			hit = _mm256_or_si256(hit, _mm256_and_si256(cleared[w], head[w]));
+		}
+
+		hit = _mm256_andnot_si256(_mm256_cmpeq_epi64(hit, zero), active);
+		__m256i moves = _mm256_andnot_si256(hit, active);
+		for (int w = 0; w < BOARD_WORDS; w++) {
+			__m256i moved = _mm256_or_si256(cleared[w], head[w]);
+
+			_mm256_store_si256((__m256i *)(b->occupied[w] + g), _mm256_blendv_epi8(occupied[w], moved, moves));
+		}
+
+		int mask = _mm256_movemask_pd(_mm256_castsi256_pd(hit));
+		for (int k = 0; k < 4; k++) {
+			b->hit[g + k] = (mask >> k) & 1 ? 0xFF : 0;
+		}
+	}
+}
+
+__attribute__((target("avx2")))
+static void commit_avx2(Batch *b, unsigned int g, unsigned int end) {
+	const __m256i one = _mm256_set1_epi8(1), ring = _mm256_set1_epi8(SNAKE_MAX_LENGTH - 1);
+
+	for (; g < end; g += 32) {
+		__m256i hit = _mm256_load_si256((const __m256i *)(b->hit + g));
+		__m256i moves = _mm256_andnot_si256(hit, _mm256_load_si256((const __m256i *)(b->active + g)));
+		__m256i grow = _mm256_load_si256((const __m256i *)(b->grow + g));
+		__m256i head = _mm256_load_si256((const __m256i *)(b->head + g));
+		__m256i length = _mm256_load_si256((const __m256i *)(b->length + g));
+
+		head = _mm256_blendv_epi8(head, _mm256_and_si256(_mm256_add_epi8(head, one), ring), moves);
+		length = _mm256_add_epi8(length, _mm256_and_si256(_mm256_and_si256(moves, grow), one));
+
+		_mm256_store_si256((__m256i *)(b->cell + g), _mm256_blendv_epi8(
+			_mm256_load_si256((const __m256i *)(b->cell + g)), _mm256_load_si256((const __m256i *)(b->target + g)), moves));
+		_mm256_store_si256((__m256i *)(b->moved + g), _mm256_blendv_epi8(
+			_mm256_load_si256((const __m256i *)(b->moved + g)), _mm256_load_si256((const __m256i *)(b->dir + g)), moves));
+		_mm256_store_si256((__m256i *)(b->state + g), _mm256_or_si256(
+			_mm256_load_si256((const __m256i *)(b->state + g)), _mm256_and_si256(hit, _mm256_set1_epi8(GAME_OVER))));
+		_mm256_store_si256((__m256i *)(b->head + g), head);
+		_mm256_store_si256((__m256i *)(b->length + g), length);
+	}
+}
+
+#endif /* BATCH_X86 */
+
+static const Kernels kernels[] = {
+	{ "scalar", targets_scalar, boards_scalar, commit_scalar },
+#ifdef BATCH_X86
+	{ "ssse3", targets_ssse3, boards_scalar, commit_ssse3 },
+	{ "avx2", targets_avx2, boards_avx2, commit_avx2 },
+#endif
+};
+
+static const Kernels *current;
+
+static int kernel_supported(const Kernels *k) {
+#ifdef BATCH_X86
+	if (!strcmp(k->name, "ssse3")) {
+		return __builtin_cpu_supports("ssse3");
+	}
+	if (!strcmp(k->name, "avx2")) {
+		return __builtin_cpu_supports("avx2");
+	}
+#endif
+	return !strcmp(k->name, "scalar");
+}
+
+int batch_kernels(const char *names[], int max) {
+	int count = 0;
+
+	for (unsigned int i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+		if (kernel_supported(&kernels[i]) && count < max) {
+			names[count++] = kernels[i].name;
+		}
+	}
+	return count;
+}
+
+int batch_use(const char *name) {
+	for (unsigned int i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+		if ((!name || !strcmp(kernels[i].name, name)) && kernel_supported(&kernels[i])) {
+			current = &kernels[i];
+			if (name) {
+				return 0;
+			}
+		}
+	}
+	return name ? -1 : 0;
+}
+
+const char *batch_kernel(void) {
+	if (!current) {
+		batch_use(NULL);
+	}
+	return current->name;
+}
+
+void batch_step(Batch *b) {
+	if (!current) {
+		batch_use(NULL);
+	}
+
+	current->targets(b, 0, b->lanes);
+
+	/* The tails are a gather from the rings */
+	for (unsigned int g = 0; g < b->lanes; g++) {
+		unsigned int i = (b->head[g] + SNAKE_MAX_LENGTH + 1 - b->length[g]) & (SNAKE_MAX_LENGTH - 1);
+
+		b->tail[g] = b->body[g * SNAKE_MAX_LENGTH + i];
+	}
+
+	current->boards(b, 0, b->lanes);
+	current->commit(b, 0, b->lanes);
+
+	/*
+	 * Scatter the heads into the rings. Games that did not move rewrite their
+	 * current head, so only the rare eating game takes a branch.
+	 */
+	for (unsigned int g = 0; g < b->n; g++) {
+		b->body[g * SNAKE_MAX_LENGTH + b->head[g]] = b->cell[g];
+
+		if (__builtin_expect(b->grow[g] & ~b->hit[g], 0)) {
+			if (b->length[g] == SNAKE_MAX_LENGTH) {
+				b->state[g] = GAME_WON;
+			} else {
+				Snake s;
+
+				s.length = b->length[g];
+				s.walls = 0;
+				s.seed = b->seed[g];
+				for (int w = 0; w < BOARD_WORDS; w++) {
+					s.occupied[w] = b->occupied[w][g];
+				}
+				place_food(&s);
+				b->food[g] = s.food;
+				b->seed[g] = s.seed;
+			}
+		}
+	}
+}
+
+void batch_get(const Batch *b, unsigned int g, Snake *s) {
+	memcpy(s->body, b->body + g * SNAKE_MAX_LENGTH, SNAKE_MAX_LENGTH);
+	s->head = b->head[g];
+	s->length = b->length[g];
+	s->food = b->food[g];
+	s->state = (GameState)b->state[g];
+	s->dir = (Direction)b->dir[g];
+	s->dir_before_stop = (Direction)b->dir_before_stop[g];
+	s->moved = (Direction)b->moved[g];
+	s->seed = b->seed[g];
+	s->level = NULL;
+	s->walls = 0;
+	for (int w = 0; w < BOARD_WORDS; w++) {
+		s->occupied[w] = b->occupied[w][g];
+	}
+}
+
+void batch_put(Batch *b, unsigned int g, const Snake *s) {
+	memcpy(b->body + g * SNAKE_MAX_LENGTH, s->body, SNAKE_MAX_LENGTH);
+	b->cell[g] = s->body[s->head];
+	b->head[g] = s->head;
+	b->length[g] = s->length;
+	b->food[g] = s->food;
+	b->state[g] = s->state;
+	b->dir[g] = s->dir;
+	b->dir_before_stop[g] = s->dir_before_stop;
+	b->moved[g] = s->moved;
+	b->seed[g] = s->seed;
+	for (int w = 0; w < BOARD_WORDS; w++) {
+		b->occupied[w][g] = s->occupied[w];
+	}
+}
+
+void batch_steer(Batch *b, unsigned int g, Direction dir) {
+	Snake s;
+
+	/* A restart needs the whole game, a turn only the direction fields */
+	if (b->state[g] != PLAYING) {
+		init_snake(&s, b->seed[g]);
+		batch_put(b, g, &s);
+		return;
+	}
+
+	s.state = PLAYING;
+	s.dir = (Direction)b->dir[g];
+	s.dir_before_stop = (Direction)b->dir_before_stop[g];
+	s.moved = (Direction)b->moved[g];
+	steer_snake(&s, dir);
+	b->dir[g] = s.dir;
+	b->dir_before_stop[g] = s.dir_before_stop;
+}
+
+static void *lane_array(unsigned int lanes, size_t size) {
+	void *p = aligned_alloc(64, lanes * size);
+
+	if (p) {
+		memset(p, 0, lanes * size);
+	}
+	return p;
+}
+
+int batch_init(Batch *b, unsigned int n, uint32_t seed) {
+	memset(b, 0, sizeof(*b));
+	b->n = n;
+	b->lanes = (n + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+
+	uint8_t **bytes[] = { &b->cell, &b->head, &b->length, &b->food, &b->state, &b->dir,
+		&b->dir_before_stop, &b->moved, &b->target, &b->tail, &b->active, &b->grow, &b->hit };
+	for (unsigned int i = 0; i < sizeof(bytes) / sizeof(bytes[0]); i++) {
+		if (!(*bytes[i] = lane_array(b->lanes, 1))) {
+			goto fail;
+		}
+	}
+	if (!(b->seed = lane_array(b->lanes, sizeof(uint32_t))) ||
+		!(b->body = lane_array(b->lanes, SNAKE_MAX_LENGTH))) {
+		goto fail;
+	}
+	for (int w = 0; w < BOARD_WORDS; w++) {
+		if (!(b->occupied[w] = lane_array(b->lanes, sizeof(uint64_t)))) {
+			goto fail;
+		}
+	}
+
+	for (unsigned int g = 0; g < b->lanes; g++) {
+		Snake s;
+
+		init_snake(&s, seed + g);
+		batch_put(b, g, &s);
+
+		/* Padding games stay over so the kernels never move them */
+		if (g >= n) {
+			b->state[g] = GAME_OVER;
+		}
+	}
+	return 0;
+
+fail:
+	batch_free(b);
+	return -1;
+}
+
+void batch_free(Batch *b) {
+	free(b->cell);
+	free(b->head);
+	free(b->length);
+	free(b->food);
+	free(b->state);
+	free(b->dir);
+	free(b->dir_before_stop);
+	free(b->moved);
+	free(b->target);
+	free(b->tail);
+	free(b->active);
+	free(b->grow);
+	free(b->hit);
+	free(b->seed);
+	free(b->body);
+	for (int w = 0; w < BOARD_WORDS; w++) {
+		free(b->occupied[w]);
+	}
+	memset(b, 0, sizeof(*b));
+}
@@ -0,0 +1,54 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+
+#include "snake.h"
+
+/* Games are processed in groups of this many byte lanes, the widest vector */
+#define BATCH_LANES 32
+
+/*
+ * Many games in struct-of-arrays form, stepped together by vector kernels.
+ * Every array has one entry per game, the rings and bitboard planes are laid
+ * out so that consecutive games are adjacent in memory.
+ */
+typedef struct {
+	unsigned int n;						/* Games */
+	unsigned int lanes;					/* n rounded up to BATCH_LANES, the padding games never play */
+
+	uint8_t *cell;						/* Head cell */
+	uint8_t *head;						/* Ring buffer index of the head */
+	uint8_t *length;
+	uint8_t *food;
+	uint8_t *state;						/* GameState */
+	uint8_t *dir;						/* Direction */
+	uint8_t *dir_before_stop;
+	uint8_t *moved;
+	uint32_t *seed;
+	uint8_t *body;						/* Ring buffer of game g at g * SNAKE_MAX_LENGTH */
+	uint64_t *occupied[BOARD_WORDS];	/* Bitboard word w of game g at occupied[w][g] */
+
+	/* Per-step scratch, 0xFF or 0 for the flags */
+	uint8_t *target, *tail, *active, *grow, *hit;
+} Batch;
+
+int batch_init(Batch *b, unsigned int n, uint32_t seed);
+void batch_free(Batch *b);
+
+/* Copy one game out of or into the batch */
+void batch_get(const Batch *b, unsigned int g, Snake *s);
+void batch_put(Batch *b, unsigned int g, const Snake *s);
+
+/* Button press on one game, same rules as steer_snake() */
+void batch_steer(Batch *b, unsigned int g, Direction dir);
+
+/* Advance every game by one tick, same rules as update_snake() */
+void batch_step(Batch *b);
+
+/* Kernel sets available on this CPU, best last, and the one in use */
+int batch_kernels(const char *names[], int max);
+int batch_use(const char *name);
+const char *batch_kernel(void);
+
+#endif /* BATCH_H */
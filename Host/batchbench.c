@@ -0,0 +1,205 @@
+/* Check the batched engine against the scalar one and measure both */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "snake.h"
+#include "tools.h"
+
+#define MAX_KERNELS 8
+
+/* Steer schedule shared by the engines, one press per game every few ticks */
+static Direction press(uint32_t *rng) {
+	uint32_t r = xorshift(rng);
+
+	return r % 32 == 0 ? STOP : (Direction)(RIGHT + (r >> 8) % 4);
+}
+
+static double now(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static int same(const Snake *a, const Snake *b) {
+	if (a->head != b->head || a->length != b->length || a->food != b->food || a->state != b->state ||
+		a->dir != b->dir || a->dir_before_stop != b->dir_before_stop || a->moved != b->moved ||
+		a->seed != b->seed || memcmp(a->occupied, b->occupied, sizeof(a->occupied))) {
+		return 0;
+	}
+	for (unsigned int i = 0; i < a->length; i++) {
+		if (snake_segment(a, i) != snake_segment(b, i)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Run the kernel and the scalar engine in lockstep, comparing every game after every tick */
+static int verify(const char *kernel, unsigned int n, unsigned int ticks, unsigned int every) {
+	Snake *ref = malloc(sizeof(Snake) * n), s;
+	Batch b;
+	uint32_t rng = 12345;
+
+	batch_use(kernel);
+	if (!ref || batch_init(&b, n, 1)) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	for (unsigned int g = 0; g < n; g++) {
+		init_snake(&ref[g], 1 + g);
+	}
+
+	for (unsigned int t = 0; t < ticks; t++) {
+		for (unsigned int g = t % every; g < n; g += every) {
+			Direction dir = press(&rng);
+
+			steer_snake(&ref[g], dir);
+			batch_steer(&b, g, dir);
+		}
+		for (unsigned int g = 0; g < n; g++) {
+			update_snake(&ref[g]);
+		}
+		batch_step(&b);
+
+		for (unsigned int g = 0; g < n; g++) {
+			batch_get(&b, g, &s);
+			if (!same(&s, &ref[g])) {
+				printf("%-7s MISMATCH in game %u at tick %u\n", kernel, g, t);
+				batch_free(&b);
+				free(ref);
+				return 1;
+			}
+		}
+	}
+
+	batch_free(&b);
+	free(ref);
+	return 0;
+}
+
+/*
+ * Finished games are started again with the next seed so that both engines
+ * step as many live games, outside the timed part like the presses.
+ */
+static void restart_scalar(Snake *games, unsigned int n, uint32_t *seed) {
+	for (unsigned int g = 0; g < n; g++) {
+		if (games[g].state != PLAYING) {
+			init_snake(&games[g], (*seed)++);
+		}
+	}
+}
+
+static void restart_batch(Batch *b, uint32_t *seed) {
+	Snake s;
+
+	for (unsigned int g = 0; g < b->n; g++) {
+		if (b->state[g] != PLAYING) {
+			init_snake(&s, (*seed)++);
+			batch_put(b, g, &s);
+		}
+	}
+}
+
+/* Game steps per second of the scalar engine, the presses and restarts are not timed */
+static double bench_scalar(unsigned int n, unsigned int ticks, unsigned int every) {
+	Snake *games = malloc(sizeof(Snake) * n);
+	uint32_t rng = 12345, seed = 1 + n;
+
+	for (unsigned int g = 0; g < n; g++) {
+		init_snake(&games[g], 1 + g);
+	}
+
+	double elapsed = 0;
+	for (unsigned int t = 0; t < ticks; t++) {
+		for (unsigned int g = t % every; g < n; g += every) {
+			steer_snake(&games[g], press(&rng));
+		}
+
+		double t0 = now();
+		for (unsigned int g = 0; g < n; g++) {
+			update_snake(&games[g]);
+		}
+		elapsed += now() - t0;
+		restart_scalar(games, n, &seed);
+	}
+
+	free(games);
+	return (double)n * ticks / elapsed;
+}
+
+static double bench_batch(const char *kernel, unsigned int n, unsigned int ticks, unsigned int every) {
+	Batch b;
+	uint32_t rng = 12345, seed = 1 + n;
+
+	batch_use(kernel);
+	batch_init(&b, n, 1);
+
+	double elapsed = 0;
+	for (unsigned int t = 0; t < ticks; t++) {
+		for (unsigned int g = t % every; g < n; g += every) {
+			batch_steer(&b, g, press(&rng));
+		}
+
+		double t0 = now();
+		batch_step(&b);
+		elapsed += now() - t0;
+		restart_batch(&b, &seed);
+	}
+
+	batch_free(&b);
+	return (double)n * ticks / elapsed;
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n GAMES   games stepped together (default 4096)\n"
+		"  -t TICKS   ticks to benchmark (default 20000)\n"
+		"  -e TICKS   ticks between presses on one game (default 16)\n"
+		"  -v TICKS   ticks to verify each kernel for, 0 to skip (default 2000)\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int n = 4096, ticks = 20000, every = 16, check = 2000;
+	const char *names[MAX_KERNELS];
+	int count = batch_kernels(names, MAX_KERNELS), failed = 0, opt;
+
+	while ((opt = getopt(argc, argv, "n:t:e:v:")) != -1) {
+		switch (opt) {
+			case 'n': n = strtoul(optarg, NULL, 0); break;
+			case 't': ticks = strtoul(optarg, NULL, 0); break;
+			case 'e': every = strtoul(optarg, NULL, 0); break;
+			case 'v': check = strtoul(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+	if (!n || !every) {
+		usage(argv[0]);
+	}
+
+	if (check) {
+		for (int k = 0; k < count; k++) {
+			failed |= verify(names[k], n < 1024 ? n : 1024, check, every);
+		}
+		printf("Verified:     %d kernels against update_snake(), %u ticks\n", count, check);
+	}
+
+	double base = bench_scalar(n, ticks, every);
+	printf("Games:        %u, press every %u ticks\n", n, every);
+	printf("%-13s %6.1f M steps/s\n", "scalar Snake", base * 1e-6);
+	for (int k = 0; k < count; k++) {
+		double rate = bench_batch(names[k], n, ticks, every);
+
+		printf("batch %-7s %6.1f M steps/s  %5.2fx\n", names[k], rate * 1e-6, rate / base);
+	}
+
+	return failed;
+}
@@ -0,0 +1,82 @@
+#include "check.h"
+
+int adjacent(unsigned a, unsigned b) {
+#if SNAKE_WALLS
+	unsigned dr = CELL_ROW(a) > CELL_ROW(b) ? CELL_ROW(a) - CELL_ROW(b) : CELL_ROW(b) - CELL_ROW(a);
+	unsigned dc = CELL_COL(a) > CELL_COL(b) ? CELL_COL(a) - CELL_COL(b) : CELL_COL(b) - CELL_COL(a);
+
+	return dr + dc == 1;
+#else
+	unsigned dr = (CELL_ROW(a) + ROWS - CELL_ROW(b)) % ROWS;
+	unsigned dc = (CELL_COL(a) + COLS - CELL_COL(b)) % COLS;
+
+	return (dc == 0 && (dr == 1 || dr == ROWS - 1)) || (dr == 0 && (dc == 1 || dc == COLS - 1));
+#endif
+}
+
+/* Whether a cell index is past the board, a full range Cell cannot be */
+static int off_board(unsigned long cell) {
+	return cell >= CELLS;
+}
+
+const char *check_snake(const Snake *s) {
+	uint64_t seen[BOARD_WORDS] = { 0 };
+
+	if (s->state != PLAYING && s->state != GAME_OVER && s->state != GAME_WON) {
+		return "invalid game state";
+	}
+	if (s->length < SNAKE_LENGTH || s->length > SNAKE_MAX_LENGTH || s->head >= SNAKE_MAX_LENGTH) {
+		return "length or head index out of range";
+	}
+	if (s->dir > LEFT || s->dir_before_stop > LEFT || s->moved < RIGHT || s->moved > LEFT) {
+		return "invalid direction";
+	}
+
+	for (unsigned i = 0; i < s->length; i++) {
+		unsigned cell = snake_segment(s, i);
+
+		if (cell >= CELLS) {
+			return "segment off the board";
+		}
+		if ((seen[cell / 64] >> (cell % 64)) & 1) {
+			return "body crosses itself";
+		}
+		seen[cell / 64] |= 1ull << (cell % 64);
+		if (i && !adjacent(cell, snake_segment(s, i - 1))) {
+			return "body is not contiguous";
+		}
+	}
+
+	unsigned walls = 0;
+
+	for (unsigned w = 0; w < BOARD_WORDS; w++) {
+		uint64_t level = s->level ? s->level[w] : 0;
+
+		if (seen[w] & level) {
+			return "body inside a wall";
+		}
+		if ((seen[w] | level) != s->occupied[w]) {
+			return "occupancy bitboard does not match the body and walls";
+		}
+		walls += __builtin_popcountll(level);
+	}
+	if (walls != s->walls) {
+		return "wall count does not match the level";
+	}
+
+	if (snake_has_food(s) && (off_board(s->food) || snake_occupies(s, s->food))) {
+		return "food off the board, under the body or in a wall";
+	}
+	if (!snake_has_food(s) && s->state != GAME_WON) {
+		return "full board not won";
+	}
+
+	/* The next step must never turn the head back into the neck */
+	if (s->state == PLAYING && s->dir != STOP && s->dir == opposite(s->moved)) {
+		return "reversal into the neck";
+	}
+	if (s->dir == STOP && s->dir_before_stop == opposite(s->moved)) {
+		return "reversal into the neck after STOP";
+	}
+	return 0;
+}
@@ -0,0 +1,17 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include "snake.h"
+
+/* Opposite of a movement direction */
+static inline Direction opposite(Direction dir) {
+	return dir == STOP ? STOP : (Direction)(RIGHT + LEFT - dir);
+}
+
+/* Whether two cells touch, across the edges only where the board wraps (SNAKE_WALLS 0) */
+int adjacent(unsigned a, unsigned b);
+
+/* Verify the engine invariants, returns NULL or a description of the first violation */
+const char *check_snake(const Snake *s);
+
+#endif /* CHECK_H */
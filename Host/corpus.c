@@ -0,0 +1,394 @@
+/*
+ * Analyzer of large corpora of recordings (Sources/replay.h). Every file is
+ * mapped into memory and cut into chunks of whole games at start records,
+ * then the chunks are replayed through the current engine on all CPUs. A
+ * game whose end hash differs from the recorded one is reported with its
+ * file and offset. Head visits per cell, causes of death and final lengths
+ * are summed per worker and merged at the end.
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "level.h"
+#include "pool.h"
+#include "recording.h"
+#include "snake.h"
+#include "tools.h"
+
+#define MAX_MISMATCHES	16
+#define CHUNK_BYTES		(1u << 20)	/* Bytes of games per unit of parallel work */
+
+/* How a game ended */
+enum { WON, BODY, LEVEL_WALL, EDGE, ABANDONED, UNFINISHED, ENDINGS };
+
+static const char *const ending_names[ENDINGS] = {
+	"won", "hit itself", "hit a level wall", "hit the edge", "abandoned", "unfinished"
+};
+
+typedef struct {
+	const char *path;
+	const uint8_t *data;
+	size_t size;
+	const char *broken;				/* What is wrong with the file, found by the index */
+	size_t broken_at;
+} File;
+
+/* Games [begin, end) of a file, begin at a start record */
+typedef struct {
+	unsigned int file;
+	size_t begin, end;
+} Chunk;
+
+typedef struct {
+	unsigned int file;
+	size_t offset;					/* Start record of the game */
+	uint32_t recorded, replayed;
+} Mismatch;
+
+/* Results of one worker, merged when all chunks are done */
+typedef struct {
+	_Alignas(64) uint64_t games, checked, records, ticks, steps;
+	uint64_t ended[ENDINGS];
+	uint64_t length[CELLS + 1];			/* Finished games per final length */
+	uint64_t visits[CELLS];				/* Moves of a head into each cell */
+	uint64_t mismatches;
+	Mismatch mismatch[MAX_MISMATCHES];
+} Stats;
+
+typedef struct {
+	const File *files;
+	const Chunk *chunks;
+	Stats *stats;
+} Corpus;
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options] FILE...\n"
+		"  -j N       worker threads (default all CPUs)\n"
+		"  -q         leave out the heatmap\n",
+		prog);
+	exit(2);
+}
+
+static int map(File *f) {
+	struct stat st;
+	int fd = open(f->path, O_RDONLY);
+
+	if (fd < 0 || fstat(fd, &st)) {
+		perror(f->path);
+		return 1;
+	}
+	f->size = st.st_size;
+	f->data = f->size ? mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+	close(fd);
+	if (f->data == MAP_FAILED) {
+		perror(f->path);
+		return 1;
+	}
+	if (f->size) {
+		madvise((void *)f->data, f->size, MADV_SEQUENTIAL);
+	}
+	return 0;
+}
+
+static void add(Chunk **chunks, size_t *n, size_t *cap, Chunk k) {
+	if (*n == *cap) {
+		*cap = *cap ? *cap * 2 : 1024;
+		if (!(*chunks = realloc(*chunks, *cap * sizeof(Chunk)))) {
+			perror("realloc");
+			exit(1);
+		}
+	}
+	(*chunks)[(*n)++] = k;
+}
+
+/*
+ * Cuts a file into chunks at the first start record after every
+ * CHUNK_BYTES. Only the record headers are decoded, so this pass runs at
+ * memory speed and the engine only runs in parallel. Appends to *chunks.
+ */
+static void cut(File *f, unsigned int file, Chunk **chunks, size_t *n, size_t *cap) {
+	const uint8_t *p, *end = f->data + f->size;
+	size_t begin = RECORDING_HEADER;
+	Record r;
+
+	if ((f->broken = recording_header(f->data, f->size))) {
+		f->broken_at = 0;
+		return;
+	}
+	for (p = f->data + RECORDING_HEADER; p < end;) {
+		const uint8_t *at = p;
+
+		if ((f->broken = recording_next(&p, end, &r))) {
+			f->broken_at = at - f->data;
+			break;
+		}
+		/* As in the replayer, a game has to start before anything happens in it */
+		if (at == f->data + RECORDING_HEADER && r.code != REPLAY_START) {
+			f->broken = "record before the first start";
+			f->broken_at = at - f->data;
+			break;
+		}
+		if (r.code == REPLAY_START && (size_t)(at - f->data) - begin >= CHUNK_BYTES) {
+			add(chunks, n, cap, (Chunk){ file, begin, at - f->data });
+			begin = at - f->data;
+		}
+	}
+	/* The rest up to a broken record still holds whole games */
+	size_t last = f->broken ? f->broken_at : f->size;
+	if (last > begin) {
+		add(chunks, n, cap, (Chunk){ file, begin, last });
+	}
+}
+
+/* What the snake ran into, the move that ended the game is the one it would make next */
+static int ending(const Snake *s) {
+	if (s->state == GAME_WON) {
+		return WON;
+	}
+
+	unsigned int target = snake_target(s);
+
+	if (target == CELLS) {
+		return EDGE;
+	}
+	if (s->level && (s->level[target / 64] >> (target % 64)) & 1) {
+		return LEVEL_WALL;
+	}
+	return BODY;
+}
+
+static void finish(Stats *st, const Snake *s, int how) {
+	st->ended[how]++;
+	st->length[s->length]++;
+}
+
+/*
+ * Replays the games of a chunk. As in the replayer, ticks while the game is
+ * paused or over do nothing and are skipped. The index only cuts chunks
+ * that open with a start; records before one are skipped all the same, so
+ * no record acts on a game that was never set up.
+ */
+static void replay_chunk(const Corpus *c, const Chunk *k, Stats *st) {
+	const File *f = &c->files[k->file];
+	const uint8_t *p = f->data + k->begin, *end = f->data + k->end;
+	size_t game = k->begin;
+	int playing = 0;
+	Record r;
+	Snake s;
+
+	while (p < end) {
+		const uint8_t *at = p;
+
+		/* The index decoded the same bytes, they cannot fail here */
+		recording_next(&p, end, &r);
+		st->records++;
+		st->ticks += r.ticks;
+		if (!playing && r.code != REPLAY_START) {
+			continue;
+		}
+		if (playing) {
+			for (uint64_t t = 0; t < r.ticks && s.state == PLAYING && s.dir != STOP; t++) {
+				update_snake(&s);
+				st->steps++;
+				if (s.state == PLAYING) {
+					st->visits[snake_segment(&s, 0)]++;
+				}
+			}
+		}
+
+		switch (r.code) {
+			case REPLAY_START:
+				if (playing && s.state == PLAYING) {
+					finish(st, &s, ABANDONED);
+				}
+				init_level(&s, r.seed, r.level ? levels[r.level - 1] : NULL);
+				st->visits[snake_segment(&s, 0)]++;
+				playing = 1;
+				game = at - f->data;
+				st->games++;
+				break;
+			case REPLAY_END: {
+				uint32_t hash = snake_hash(&s);
+
+				st->checked++;
+				if (s.state == PLAYING || hash != r.hash) {
+					if (st->mismatches < MAX_MISMATCHES) {
+						st->mismatch[st->mismatches] = (Mismatch){ k->file, game, r.hash, hash };
+					}
+					st->mismatches++;
+				}
+				if (s.state != PLAYING) {
+					finish(st, &s, ending(&s));
+				}
+				break;
+			}
+			default:
+				steer_snake(&s, (Direction)r.code);
+				break;
+		}
+	}
+	if (playing && s.state == PLAYING) {
+		finish(st, &s, UNFINISHED);
+	}
+}
+
+static void corpus_chunk(void *arg, int worker, uint64_t begin, uint64_t end) {
+	const Corpus *c = arg;
+
+	for (uint64_t i = begin; i < end; i++) {
+		replay_chunk(c, &c->chunks[i], &c->stats[worker]);
+	}
+}
+
+/* Head visits as a grid of per mille of all visits, the layout of the matrix */
+static void heatmap(const uint64_t visits[CELLS]) {
+	uint64_t total = 0;
+
+	for (unsigned int cell = 0; cell < CELLS; cell++) {
+		total += visits[cell];
+	}
+	if (!total || COLS > 64) {
+		return;
+	}
+	printf("Head visits per mille of all visits, row 0 at the top:\n");
+	for (unsigned int row = 0; row < ROWS; row++) {
+		printf(" ");
+		for (unsigned int col = 0; col < COLS; col++) {
+			printf(" %3.0f", 1000.0 * visits[CELL(row, col)] / total);
+		}
+		printf("\n");
+	}
+}
+
+int main(int argc, char *argv[]) {
+	int workers = pool_cpus(), quiet = 0, opt, bad = 0;
+
+	while ((opt = getopt(argc, argv, "j:q")) != -1) {
+		switch (opt) {
+			case 'j': workers = atoi(optarg); break;
+			case 'q': quiet = 1; break;
+			default: usage(argv[0]);
+		}
+	}
+	if (workers < 1 || optind == argc) {
+		usage(argv[0]);
+	}
+
+	unsigned int nfiles = argc - optind;
+	File *files = calloc(nfiles, sizeof(File));
+	Chunk *chunks = NULL;
+	size_t nchunks = 0, cap = 0, bytes = 0;
+	struct timespec t0, t1, t2;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (unsigned int i = 0; i < nfiles; i++) {
+		files[i].path = argv[optind + i];
+		if (map(&files[i])) {
+			return 1;
+		}
+		cut(&files[i], i, &chunks, &nchunks, &cap);
+		if (files[i].broken) {
+			printf("%s: %s at offset %zu, replaying the games before it\n", files[i].path, files[i].broken,
+				files[i].broken_at);
+			bad = 1;
+		}
+		bytes += files[i].size;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	Corpus c = { files, chunks, aligned_alloc(64, sizeof(Stats) * workers) };
+	memset(c.stats, 0, sizeof(Stats) * workers);
+	if (nchunks > UINT32_MAX) {
+		fprintf(stderr, "too many chunks\n");
+		return 1;
+	}
+	pool_for(nchunks, workers, 1, corpus_chunk, &c);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	/* Merge the per-worker results */
+	Stats total;
+	memset(&total, 0, sizeof(total));
+	for (int w = 0; w < workers; w++) {
+		const Stats *st = &c.stats[w];
+
+		total.games += st->games;
+		total.checked += st->checked;
+		total.records += st->records;
+		total.ticks += st->ticks;
+		total.steps += st->steps;
+		for (int i = 0; i < ENDINGS; i++) {
+			total.ended[i] += st->ended[i];
+		}
+		for (int i = 0; i <= CELLS; i++) {
+			total.length[i] += st->length[i];
+		}
+		for (int i = 0; i < CELLS; i++) {
+			total.visits[i] += st->visits[i];
+		}
+		for (uint64_t i = 0; i < st->mismatches && i < MAX_MISMATCHES; i++) {
+			if (total.mismatches + i < MAX_MISMATCHES) {
+				total.mismatch[total.mismatches + i] = st->mismatch[i];
+			}
+		}
+		total.mismatches += st->mismatches;
+	}
+
+	double index = seconds(&t0, &t1), run = seconds(&t1, &t2);
+	uint64_t ended = 0;
+
+	printf("Corpus:       %u files, %.1f MB, %zu chunks, %" PRIu64 " games, %" PRIu64 " records, %" PRIu64 " ticks\n",
+		nfiles, bytes * 1e-6, nchunks, total.games, total.records, total.ticks);
+	printf("Index:        %.3f s, %.0f MB/s\n", index, bytes / index * 1e-6);
+	printf("Replay:       %.3f s on %d threads, %.0f MB/s, %.1f M engine steps/s\n", run, workers,
+		bytes / run * 1e-6, total.steps / run * 1e-6);
+	printf("Endings:     ");
+	for (int i = 0; i < ENDINGS; i++) {
+		printf(" %" PRIu64 " %s%s", total.ended[i], ending_names[i], i + 1 < ENDINGS ? "," : "\n");
+		ended += total.ended[i];
+	}
+	if (ended) {
+		uint64_t seen = 0, median = 0, p90 = 0, longest = 0, sum = 0;
+
+		for (int i = 0; i <= CELLS; i++) {
+			if (!total.length[i]) {
+				continue;
+			}
+			sum += (uint64_t)i * total.length[i];
+			seen += total.length[i];
+			longest = i;
+			if (!median && seen * 2 >= ended) median = i;
+			if (!p90 && seen * 10 >= ended * 9) p90 = i;
+		}
+		printf("Final length: mean %.2f, median %" PRIu64 ", 90th %% %" PRIu64 ", max %" PRIu64 "\n",
+			(double)sum / ended, median, p90, longest);
+	}
+	printf("Checked:      %" PRIu64 " finished games, %" PRIu64 " differ\n", total.checked, total.mismatches);
+	for (uint64_t i = 0; i < total.mismatches && i < MAX_MISMATCHES; i++) {
+		const Mismatch *m = &total.mismatch[i];
+
+		printf("  %s: game at offset %zu, recorded %08x, replayed %08x\n", files[m->file].path, m->offset,
+			m->recorded, m->replayed);
+	}
+	if (!quiet) {
+		heatmap(total.visits);
+	}
+
+	for (unsigned int i = 0; i < nfiles; i++) {
+		if (files[i].size) {
+			munmap((void *)files[i].data, files[i].size);
+		}
+	}
+	free(c.stats);
+	free(chunks);
+	free(files);
+	return bad || total.mismatches;
+}
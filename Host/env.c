@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "env.h"
+
+/* Bits of a byte spread to the low bit of eight bytes, one matrix column of ENV_GRID */
+static uint64_t spread[256];
+
+static void restart(Env *e, unsigned int g) {
+	Snake s;
+
+	if (!e->next_seed) {
+		e->next_seed++;
+	}
+	init_snake(&s, e->next_seed++);
+	batch_put(&e->b, g, &s);
+	e->ticks[g] = 0;
+}
+
+int env_init(Env *e, unsigned int n, EnvObs obs, uint32_t seed, uint32_t max_ticks) {
+	memset(e, 0, sizeof(*e));
+	if (batch_init(&e->b, n, 1)) {
+		return -1;
+	}
+	if (!(e->ticks = calloc(n, sizeof(uint32_t)))) {
+		batch_free(&e->b);
+		return -1;
+	}
+	e->obs = obs;
+	e->max_ticks = max_ticks;
+	e->next_seed = seed;
+
+	if (!spread[1]) {
+		for (unsigned int x = 0; x < 256; x++) {
+			for (unsigned int row = 0; row < ROWS; row++) {
+				spread[x] |= (uint64_t)((x >> row) & 1) << (row * 8);
+			}
+		}
+	}
+
+	env_reset(e, NULL);
+	return 0;
+}
+
+void env_free(Env *e) {
+	batch_free(&e->b);
+	free(e->ticks);
+	memset(e, 0, sizeof(*e));
+}
+
+size_t env_obs_size(const Env *e) {
+	return e->obs == ENV_PLANES ? ENV_PLANES_SIZE : ENV_GRID_SIZE;
+}
+
+void env_reset(Env *e, void *obs) {
+	for (unsigned int g = 0; g < e->b.n; g++) {
+		restart(e, g);
+	}
+	if (obs) {
+		env_observe(e, obs);
+	}
+}
+
+void env_observe(const Env *e, void *obs) {
+	const Batch *b = &e->b;
+
+	if (e->obs == ENV_PLANES) {
+		uint64_t *p = obs;
+
+		for (unsigned int g = 0; g < b->n; g++, p += 3 * BOARD_WORDS) {
+			for (int w = 0; w < BOARD_WORDS; w++) {
+				p[w] = b->occupied[w][g];
+				p[BOARD_WORDS + w] = (uint64_t)(b->cell[g] / 64 == w) << (b->cell[g] % 64);
+				p[2 * BOARD_WORDS + w] = (uint64_t)(b->food[g] / 64 == w && b->length[g] < SNAKE_MAX_LENGTH) << (b->food[g] % 64);
+			}
+		}
+		return;
+	}
+
+	uint8_t *p = obs;
+	for (unsigned int g = 0; g < b->n; g++, p += ENV_GRID_SIZE) {
+		/* Cells are column-major like the bitboard, so every board byte is one grid column */
+		for (int w = 0; w < BOARD_WORDS; w++) {
+			for (unsigned int i = 0; i < 8; i++) {
+				uint64_t column = spread[(b->occupied[w][g] >> (i * 8)) & 0xFF];
+
+				memcpy(p + w * 64 + i * 8, &column, sizeof(column));
+			}
+		}
+		p[b->cell[g]] = ENV_HEAD;
+		if (b->length[g] < SNAKE_MAX_LENGTH) {
+			p[b->food[g]] = ENV_FOOD;
+		}
+	}
+}
+
+void env_step(Env *e, const uint8_t *actions, void *obs, int8_t *reward, uint8_t *done) {
+	Batch *b = &e->b;
+
+	for (unsigned int g = 0; g < b->n; g++) {
+		if (actions[g] != STOP) {
+			batch_steer(b, g, (Direction)actions[g]);
+		}
+	}
+
+	batch_step(b);
+
+	/* The step leaves its eat and crash flags behind, 0xFF or 0 */
+	for (unsigned int g = 0; g < b->n; g++) {
+		uint8_t end = b->state[g] != PLAYING ? ENV_TERMINAL : ENV_RUNNING;
+
+		if (reward) {
+			reward[g] = b->hit[g] ? -1 : (b->grow[g] & 1);
+		}
+		if (++e->ticks[g] == e->max_ticks && !end) {
+			end = ENV_TRUNCATED;
+		}
+		if (done) {
+			done[g] = end;
+		}
+		if (end) {
+			restart(e, g);
+		}
+	}
+
+	if (obs) {
+		env_observe(e, obs);
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "batch.h"
+
+/* Observation formats, written per game one after another */
+typedef enum {
+	ENV_PLANES,		/* uint64_t bitboards of body, head and food, BOARD_WORDS each */
+	ENV_GRID		/* One byte per cell at CELL(row, col), see the ENV_* cell values */
+} EnvObs;
+
+#define ENV_PLANES_SIZE	(3 * BOARD_WORDS * sizeof(uint64_t))
+#define ENV_GRID_SIZE	CELLS
+
+/* Cell values of ENV_GRID */
+#define ENV_EMPTY	0
+#define ENV_BODY	1
+#define ENV_HEAD	2
+#define ENV_FOOD	3
+
+/* Values of the done flags */
+#define ENV_RUNNING		0
+#define ENV_TERMINAL	1	/* Game over or won */
+#define ENV_TRUNCATED	2	/* Tick limit reached */
+
+/*
+ * A batch of games for training against the rules of update_snake(). The
+ * caller owns every buffer, the environment only writes into them, so one
+ * step allocates nothing. Games that end restart with a new seed at once
+ * and report the first observation of the next game.
+ */
+typedef struct {
+	Batch b;
+	EnvObs obs;
+	uint32_t max_ticks;				/* Truncate games after this many steps, 0 for no limit */
+	uint32_t *ticks;				/* Steps of the current game */
+	uint32_t next_seed;
+} Env;
+
+int env_init(Env *e, unsigned int n, EnvObs obs, uint32_t seed, uint32_t max_ticks);
+void env_free(Env *e);
+
+/* Bytes of observation per game */
+size_t env_obs_size(const Env *e);
+
+/* Start every game over and write the observations, obs may be NULL */
+void env_reset(Env *e, void *obs);
+
+/*
+ * Press one button per game and advance every game by one tick. Actions are
+ * Directions, STOP meaning no press since pausing is of no use to an agent.
+ * The reward is 1 for eating, -1 for a crash and 0 otherwise. Any of obs,
+ * reward and done may be NULL; obs must be 8 byte aligned for ENV_PLANES.
+ */
+void env_step(Env *e, const uint8_t *actions, void *obs, int8_t *reward, uint8_t *done);
+
+/* Write the current observations without stepping */
+void env_observe(const Env *e, void *obs);
+
+#endif /* ENV_H */
@@ -0,0 +1,201 @@
+/* Steps per second of the training environment, optionally through a shared memory ring */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "env.h"
+#include "ring.h"
+#include "tools.h"
+
+#define MAX_SIZES 8
+#define ACTION_ROWS 64		/* Rows of random actions, cycled */
+
+static double now(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* Layout of one ring slot: observations, then rewards, then done flags */
+typedef struct {
+	size_t obs, reward, done, size;
+} Slot;
+
+static Slot slot_layout(unsigned int n, size_t obs_size) {
+	Slot s;
+
+	s.obs = 0;
+	s.reward = n * obs_size;
+	s.done = s.reward + n;
+	s.size = s.done + n;
+	return s;
+}
+
+/* Trainer side: take every frame in place and add up what it saw */
+static int consume(const char *name, unsigned int n, size_t obs_size) {
+	Ring r;
+	const uint8_t *frame;
+	uint64_t frames = 0, ended = 0;
+	int64_t reward = 0;
+
+	if (ring_open(&r, name)) {
+		perror("ring_open");
+		return 1;
+	}
+
+	Slot slot = slot_layout(n, obs_size);
+
+	double t0 = now();
+	while ((frame = ring_next(&r))) {
+		const int8_t *rewards = (const int8_t *)(frame + slot.reward);
+		const uint8_t *done = frame + slot.done;
+
+		for (unsigned int g = 0; g < n; g++) {
+			reward += rewards[g];
+			ended += done[g] != ENV_RUNNING;
+		}
+		frames++;
+		ring_release(&r);
+	}
+	double elapsed = now() - t0;
+
+	printf("  consumer: %" PRIu64 " frames, %.1f M game steps/s, %" PRIu64 " games ended, reward %" PRId64 "\n",
+		frames, frames * n / elapsed * 1e-6, ended, reward);
+	fflush(stdout);
+	ring_close(&r);
+	return 0;
+}
+
+/* Step the environment until steps game steps are done, into the ring when it is given */
+static double run(unsigned int n, EnvObs kind, uint64_t steps, Ring *ring) {
+	Env e;
+	uint8_t *actions = malloc((size_t)n * ACTION_ROWS);
+	size_t obs_size = kind == ENV_PLANES ? ENV_PLANES_SIZE : ENV_GRID_SIZE;
+	Slot slot = slot_layout(n, obs_size);
+	uint8_t *local = aligned_alloc(64, (slot.size + 63) / 64 * 64);
+	uint32_t x = 1;
+
+	if (!actions || !local || env_init(&e, n, kind, 1, 1000)) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	/* Mostly keep going, sometimes turn */
+	for (size_t i = 0; i < (size_t)n * ACTION_ROWS; i++) {
+		uint32_t r = xorshift(&x);
+
+		actions[i] = r % 4 ? STOP : RIGHT + (r >> 8) % 4;
+	}
+
+	uint64_t ticks = (steps + n - 1) / n;
+	double t0 = now();
+	for (uint64_t t = 0; t < ticks; t++) {
+		uint8_t *frame = ring ? ring_acquire(ring) : local;
+
+		env_step(&e, actions + t % ACTION_ROWS * n, frame + slot.obs,
+			(int8_t *)(frame + slot.reward), frame + slot.done);
+		if (ring) {
+			ring_publish(ring);
+		}
+	}
+	double elapsed = now() - t0;
+
+	env_free(&e);
+	free(local);
+	free(actions);
+	return ticks * n / elapsed;
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n LIST    batch sizes (default 1,64,4096)\n"
+		"  -s STEPS   game steps per measurement (default 20000000)\n"
+		"  -r         also hand every frame to a second process through a shared memory ring\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int sizes[MAX_SIZES] = { 1, 64, 4096 }, count = 3;
+	uint64_t steps = 20000000;
+	int use_ring = 0, opt;
+
+	while ((opt = getopt(argc, argv, "n:s:r")) != -1) {
+		switch (opt) {
+			case 'n': {
+				char *p = optarg;
+
+				for (count = 0; count < MAX_SIZES && *p; count++) {
+					sizes[count] = strtoul(p, &p, 0);
+					if (*p == ',') p++;
+				}
+				break;
+			}
+			case 's': steps = strtoull(optarg, NULL, 0); break;
+			case 'r': use_ring = 1; break;
+			default: usage(argv[0]);
+		}
+	}
+	for (unsigned int i = 0; i < count; i++) {
+		if (!sizes[i]) {
+			usage(argv[0]);
+		}
+	}
+
+	printf("Kernel:       %s\n", batch_kernel());
+	printf("%-8s %14s %14s\n", "batch", "planes", "grid");
+	for (unsigned int i = 0; i < count; i++) {
+		printf("%-8u", sizes[i]);
+		for (EnvObs kind = ENV_PLANES; kind <= ENV_GRID; kind++) {
+			printf(" %8.2f M/s  ", run(sizes[i], kind, steps, NULL) * 1e-6);
+			fflush(stdout);
+		}
+		printf("\n");
+	}
+
+	if (!use_ring) {
+		return 0;
+	}
+
+	/* Same again with a consumer process on the other end of the ring */
+	int failed = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		for (EnvObs kind = ENV_PLANES; kind <= ENV_GRID; kind++) {
+			char name[64];
+			Ring ring;
+			size_t obs_size = kind == ENV_PLANES ? ENV_PLANES_SIZE : ENV_GRID_SIZE;
+			Slot slot = slot_layout(sizes[i], obs_size);
+
+			snprintf(name, sizeof(name), "/snake-env-%d", (int)getpid());
+			if (ring_create(&ring, name, 64, slot.size)) {
+				perror("ring_create");
+				return 1;
+			}
+
+			printf("Ring, batch %u, %s:\n", sizes[i], kind == ENV_PLANES ? "planes" : "grid");
+			fflush(stdout);
+			pid_t child = fork();
+			if (child == 0) {
+				_exit(consume(name, sizes[i], obs_size));
+			}
+
+			double rate = run(sizes[i], kind, steps, &ring);
+			ring_finish(&ring);
+
+			int status;
+			waitpid(child, &status, 0);
+			failed |= !WIFEXITED(status) || WEXITSTATUS(status);
+			printf("  producer: %.1f M game steps/s\n", rate * 1e-6);
+			ring_close(&ring);
+			ring_unlink(name);
+		}
+	}
+	return failed;
+}
@@ -0,0 +1,124 @@
+/* Generate and verify the Hamiltonian cycle tables, then play the cycle autopilot to a full board */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "autopilot.h"
+#include "check.h"
+#include "hamilton.h"
+#include "snake.h"
+
+/*
+ * Serpentine through the columns: up the even ones, down the odd ones. With
+ * an even number of columns the last one ends next to the first.
+ */
+static void generate(void) {
+	uint8_t next[CELLS], order[CELLS], path[CELLS];
+
+	for (unsigned int i = 0; i < CELLS; i++) {
+		unsigned int col = i / ROWS, row = col % 2 ? ROWS - 1 - i % ROWS : i % ROWS;
+
+		path[i] = CELL(row, col);
+	}
+	for (unsigned int i = 0; i < CELLS; i++) {
+		next[path[i]] = path[(i + 1) % CELLS];
+		order[path[i]] = i;
+	}
+
+	printf("/* Generated by Host/hamilton -g, do not edit */\n\n#include \"hamilton.h\"\n");
+	const uint8_t *tables[2] = { next, order };
+	const char *names[2] = { "hamilton_next", "hamilton_order" };
+	for (int t = 0; t < 2; t++) {
+		printf("\nconst uint8_t %s[CELLS] = {", names[t]);
+		for (unsigned int i = 0; i < CELLS; i++) {
+			printf("%s%3u%s", i % ROWS ? " " : "\n\t", tables[t][i], i + 1 < CELLS ? "," : "");
+		}
+		printf("\n};\n");
+	}
+}
+
+/* The tables describe one cycle through every cell, returns NULL or what is wrong */
+static const char *verify(void) {
+	uint64_t seen[BOARD_WORDS] = { 0 };
+	unsigned int cell = 0;
+
+	for (unsigned int i = 0; i < CELLS; i++) {
+		if (hamilton_next[cell] >= CELLS) {
+			return "successor off the board";
+		}
+		if ((seen[cell / 64] >> (cell % 64)) & 1) {
+			return "cycle closes before covering the board";
+		}
+		seen[cell / 64] |= 1ull << (cell % 64);
+		if (!adjacent(cell, hamilton_next[cell])) {
+			return "successor is not a neighbour";
+		}
+		if (hamilton_order[cell] != hamilton_order[0] + i) {
+			return "order does not count along the cycle";
+		}
+		cell = hamilton_next[cell];
+	}
+	return cell == 0 ? NULL : "cycle does not return to its start";
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -g         print the tables as C source and exit\n"
+		"  -n GAMES   games to play with each policy (default 1000)\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int games = 1000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "gn:")) != -1) {
+		switch (opt) {
+			case 'g': generate(); return 0;
+			case 'n': games = strtoul(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+	if (!games) {
+		usage(argv[0]);
+	}
+
+	const char *why = verify();
+	printf("Cycle:        %s\n", why ? why : "single cycle through all cells");
+	if (why) {
+		return 1;
+	}
+
+	/* Both policies have to fill the board in every game, the food is all that differs */
+	for (int shortcuts = 0; shortcuts < 2; shortcuts++) {
+		uint64_t ticks = 0, longest = 0;
+
+		for (unsigned int g = 0; g < games; g++) {
+			Snake s;
+			uint64_t t;
+
+			init_snake(&s, 1 + g);
+			for (t = 0; s.state == PLAYING && t < (uint64_t)CELLS * CELLS; t++) {
+				steer_snake(&s, hamilton_steer(&s, shortcuts));
+				update_snake(&s);
+				if ((why = check_snake(&s))) {
+					printf("game %u tick %" PRIu64 ": %s\n", g, t, why);
+					return 1;
+				}
+			}
+			if (s.state != GAME_WON) {
+				printf("game %u: %s at length %u\n", g, s.state == GAME_OVER ? "died" : "timed out", s.length);
+				return 1;
+			}
+			ticks += t;
+			longest = t > longest ? t : longest;
+		}
+		printf("%-13s %u of %u games won, %.0f ticks mean, %" PRIu64 " worst\n",
+			shortcuts ? "Shortcuts:" : "Cycle only:", games, games, (double)ticks / games, longest);
+	}
+	return 0;
+}
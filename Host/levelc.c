@@ -0,0 +1,272 @@
+/*
+ * Level compiler. Reads ASCII art levels, checks that each one can be
+ * played and writes them as wall bitboards in the occupancy layout, a C
+ * table for the firmware and optionally a raw pack of the same bytes.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "autopilot.h"
+#include "check.h"
+#include "snake.h"
+
+#define MAX_LEVELS	64
+#define NAME_SIZE	48
+
+typedef struct {
+	char name[NAME_SIZE];
+	uint64_t walls[BOARD_WORDS];
+	unsigned int line;			/* Line of the name in the source */
+} Level;
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options] LEVELS\n"
+		"  -b FILE    also write the levels as a raw pack of %zu byte records\n"
+		"  -g GAMES   autopilot games played on every level (default 100)\n",
+		prog, sizeof(uint64_t) * BOARD_WORDS);
+	exit(2);
+}
+
+static int wall(const uint64_t walls[BOARD_WORDS], unsigned int cell) {
+	return (walls[cell / 64] >> (cell % 64)) & 1;
+}
+
+/* Reads every level of a file, returns the number read or -1 after printing the error */
+static int parse(const char *path, Level *levels) {
+	FILE *f = fopen(path, "r");
+	char text[256];
+	unsigned int line = 0, row = ROWS;
+	int n = 0;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	while (fgets(text, sizeof(text), f)) {
+		size_t len = strcspn(text, "\r\n");
+
+		line++;
+		text[len] = 0;
+		if (text[0] == ';' || (len == 0 && row == ROWS)) {
+			continue;
+		}
+		if (text[0] == '=') {
+			if (row != ROWS) {
+				fprintf(stderr, "%s:%u: level has %u rows, not %d\n", path, line, row, ROWS);
+				goto fail;
+			}
+			if (n == MAX_LEVELS) {
+				fprintf(stderr, "%s:%u: more than %d levels\n", path, line, MAX_LEVELS);
+				goto fail;
+			}
+			memset(&levels[n], 0, sizeof(levels[n]));
+			snprintf(levels[n].name, NAME_SIZE, "%s", text + 1 + strspn(text + 1, " \t"));
+			levels[n++].line = line;
+			row = 0;
+			continue;
+		}
+		if (row == ROWS) {
+			fprintf(stderr, "%s:%u: row outside a level\n", path, line);
+			goto fail;
+		}
+		if (len != COLS || strspn(text, "#.") != COLS) {
+			fprintf(stderr, "%s:%u: a row is %d cells of '#' or '.'\n", path, line, COLS);
+			goto fail;
+		}
+		for (unsigned int col = 0; col < COLS; col++) {
+			if (text[col] == '#') {
+				levels[n - 1].walls[CELL(row, col) / 64] |= 1ull << (CELL(row, col) % 64);
+			}
+		}
+		row++;
+	}
+	if (row != ROWS) {
+		fprintf(stderr, "%s:%u: level has %u rows, not %d\n", path, line, row, ROWS);
+		goto fail;
+	}
+	fclose(f);
+	return n;
+
+fail:
+	fclose(f);
+	return -1;
+}
+
+/*
+ * A level can be played when the start row is free, every free cell can be
+ * reached from the start and none of them is a dead end. The snake cannot
+ * turn around, so food in a dead end could only be eaten by dying.
+ */
+static const char *verify(const Level *l, unsigned int *where) {
+	static const Direction turns[4] = { RIGHT, DOWN, UP, LEFT };
+	uint64_t seen[BOARD_WORDS] = { 0 };
+	unsigned int stack[CELLS], top = 0, free = 0, reached = 0;
+
+	for (unsigned int col = 0; col <= SNAKE_LENGTH; col++) {
+		if (wall(l->walls, CELL(0, col))) {
+			*where = CELL(0, col);
+			return "wall on the start of the snake";
+		}
+	}
+
+	for (unsigned int cell = 0; cell < CELLS; cell++) {
+		unsigned int exits = 0;
+
+		if (wall(l->walls, cell)) {
+			continue;
+		}
+		free++;
+		for (int d = 0; d < 4; d++) {
+			unsigned int next = cell_step(cell, turns[d]);
+
+			exits += next != CELLS && !wall(l->walls, next);
+		}
+		if (exits < 2) {
+			*where = cell;
+			return "dead end";
+		}
+	}
+
+	/* Flood fill from the start over the free cells, with the same edges as the game */
+	stack[top++] = CELL(0, 0);
+	seen[0] |= 1;
+	while (top) {
+		unsigned int cell = stack[--top];
+
+		reached++;
+		for (int d = 0; d < 4; d++) {
+			unsigned int next = cell_step(cell, turns[d]);
+
+			if (next != CELLS && !wall(l->walls, next) && !wall(seen, next)) {
+				seen[next / 64] |= 1ull << (next % 64);
+				stack[top++] = next;
+			}
+		}
+	}
+	if (reached != free) {
+		for (unsigned int cell = 0; cell < CELLS; cell++) {
+			if (!wall(l->walls, cell) && !wall(seen, cell)) {
+				*where = cell;
+				break;
+			}
+		}
+		return "free cell cut off from the start";
+	}
+	return NULL;
+}
+
+/* Autopilot games on a level, every state checked, returns 0 or 1 after printing the violation */
+static int play(const Level *l, unsigned int games, unsigned int *won, double *mean) {
+	uint64_t lengths = 0;
+	const char *why;
+
+	*won = 0;
+	for (unsigned int g = 0; g < games; g++) {
+		Snake s;
+
+		init_level(&s, 1 + g, l->walls);
+		for (uint64_t t = 0; s.state == PLAYING && t < (uint64_t)CELLS * CELLS; t++) {
+			steer_snake(&s, autopilot_steer(&s));
+			update_snake(&s);
+			if ((why = check_snake(&s))) {
+				fprintf(stderr, "%s, game %u tick %" PRIu64 ": %s\n", l->name, g, t, why);
+				return 1;
+			}
+		}
+		*won += s.state == GAME_WON;
+		lengths += s.length;
+	}
+	*mean = games ? (double)lengths / games : 0;
+	return 0;
+}
+
+static void emit(const Level *levels, int n, const char *source) {
+	printf("/* Generated by Host/levelc %s, do not edit */\n\n#include \"level.h\"\n\n", source);
+	printf("#if ROWS != %d || COLS != %d\n#error \"levels were compiled for the %dx%d matrix\"\n#endif\n\n",
+		ROWS, COLS, COLS, ROWS);
+	printf("const uint64_t levels[][BOARD_WORDS] = {\n");
+	for (int i = 0; i < n; i++) {
+		printf("\t{");
+		for (int w = 0; w < BOARD_WORDS; w++) {
+			printf(" 0x%016" PRIx64 "ull%s", levels[i].walls[w], w + 1 < BOARD_WORDS ? "," : "");
+		}
+		printf(" },\t/* %s */\n", levels[i].name);
+	}
+	printf("};\n\nconst unsigned int level_count = sizeof(levels) / sizeof(levels[0]);\n");
+}
+
+/* The pack holds the bitboard words little endian, the byte order of the board */
+static int pack(const Level *levels, int n, const char *path) {
+	FILE *f = fopen(path, "wb");
+
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+	for (int i = 0; i < n; i++) {
+		for (int w = 0; w < BOARD_WORDS; w++) {
+			for (int b = 0; b < 8; b++) {
+				fputc((int)(levels[i].walls[w] >> (b * 8)) & 0xFF, f);
+			}
+		}
+	}
+	if (fclose(f)) {
+		perror(path);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	static Level levels[MAX_LEVELS];
+	const char *pack_path = NULL;
+	unsigned int games = 100;
+	int opt, n, bad = 0;
+
+	while ((opt = getopt(argc, argv, "b:g:")) != -1) {
+		switch (opt) {
+			case 'b': pack_path = optarg; break;
+			case 'g': games = strtoul(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+	if (optind + 1 != argc) {
+		usage(argv[0]);
+	}
+	if ((n = parse(argv[optind], levels)) < 0) {
+		return 1;
+	}
+
+	/* The report goes to stderr so the table can be redirected */
+	for (int i = 0; i < n; i++) {
+		unsigned int where = 0, won, walls = 0;
+		const char *why = verify(&levels[i], &where);
+		double mean;
+
+		if (why) {
+			fprintf(stderr, "%s:%u: %s: %s at row %u column %u\n", argv[optind], levels[i].line, levels[i].name, why,
+				CELL_ROW(where), CELL_COL(where));
+			bad = 1;
+			continue;
+		}
+		if (play(&levels[i], games, &won, &mean)) {
+			return 1;
+		}
+		for (int w = 0; w < BOARD_WORDS; w++) {
+			walls += __builtin_popcountll(levels[i].walls[w]);
+		}
+		fprintf(stderr, "%-12s %3u walls, autopilot won %u of %u games, length %.1f mean\n", levels[i].name, walls,
+			won, games, mean);
+	}
+	if (bad) {
+		return 1;
+	}
+
+	emit(levels, n, argv[optind]);
+	return pack_path ? pack(levels, n, pack_path) : 0;
+}
@@ -0,0 +1,346 @@
+/* Monte Carlo tree search autopilot, searched in parallel over a shared transposition table */
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "pool.h"
+#include "snake.h"
+#include "tools.h"
+
+#define ACTIONS 4			/* RIGHT, DOWN, UP, LEFT */
+#define MAX_DEPTH 32		/* Tree steps per playout */
+#define MAX_THREADS 64
+#define PROBES 8			/* Table entries looked at per key */
+#define VALUE_ONE 256		/* Fixed point of the values in the table */
+#define BUSY 1				/* Key of an entry being taken over */
+
+/*
+ * One searched position. The key identifies the position, the action
+ * statistics are updated with atomic adds by all threads at once. Entries
+ * from earlier moves are taken over by the first thread that needs the
+ * slot, which marks it BUSY while it clears the statistics.
+ */
+typedef struct {
+	_Alignas(64) _Atomic uint64_t key;
+	_Atomic uint32_t move;				/* Move of the game the entry was made for */
+	_Atomic uint32_t visits;
+	_Atomic uint32_t n[ACTIONS];		/* Playouts through each action, virtual losses included */
+	_Atomic int32_t w[ACTIONS];			/* Their total value, VALUE_ONE per food */
+} Entry;
+
+typedef struct {
+	Entry *table;
+	uint64_t mask;
+	uint32_t move;
+	Snake root;
+	unsigned int horizon;				/* Random steps after leaving the tree */
+	double explore;
+} Search;
+
+/* Zobrist keys of body cells, the head cell, the food cell and the last step */
+static uint64_t zobrist_body[CELLS], zobrist_head[CELLS], zobrist_food[CELLS], zobrist_moved[5];
+
+static void zobrist_init(void) {
+	uint64_t x = 0x5EED;
+
+	for (int i = 0; i < CELLS; i++) {
+		zobrist_body[i] = splitmix64(&x);
+		zobrist_head[i] = splitmix64(&x);
+		zobrist_food[i] = splitmix64(&x);
+	}
+	for (int i = 0; i < 5; i++) {
+		zobrist_moved[i] = splitmix64(&x);
+	}
+}
+
+/*
+ * Key of a position. The food generator state is left out on purpose: it
+ * only decides where later food appears, which the search treats as chance.
+ */
+static uint64_t zobrist(const Snake *s) {
+	uint64_t key = zobrist_head[snake_segment(s, 0)] ^ zobrist_food[s->food] ^ zobrist_moved[s->moved];
+
+	for (int w = 0; w < BOARD_WORDS; w++) {
+		for (uint64_t bits = s->occupied[w]; bits; bits &= bits - 1) {
+			key ^= zobrist_body[w * 64 + __builtin_ctzll(bits)];
+		}
+	}
+	return key < 2 ? key + 2 : key;		/* 0 is a free entry, 1 is BUSY */
+}
+
+/* Entry of a position, taking over a free or stale one if needed, NULL when the probes are full */
+static Entry *lookup(Search *se, uint64_t key) {
+	for (int i = 0; i < PROBES; i++) {
+		Entry *e = &se->table[(key + i) & se->mask];
+		uint64_t old = atomic_load_explicit(&e->key, memory_order_acquire);
+
+		if (old == key) {
+			return e;
+		}
+		if (old == BUSY || (old && atomic_load_explicit(&e->move, memory_order_relaxed) == se->move)) {
+			continue;
+		}
+		if (atomic_compare_exchange_strong(&e->key, &old, BUSY)) {
+			atomic_store_explicit(&e->move, se->move, memory_order_relaxed);
+			atomic_store_explicit(&e->visits, 0, memory_order_relaxed);
+			for (int a = 0; a < ACTIONS; a++) {
+				atomic_store_explicit(&e->n[a], 0, memory_order_relaxed);
+				atomic_store_explicit(&e->w[a], 0, memory_order_relaxed);
+			}
+			atomic_store_explicit(&e->key, key, memory_order_release);
+			return e;
+		}
+		if (old == key) {
+			return e;
+		}
+	}
+	return NULL;
+}
+
+/* Actions are directions RIGHT + a, turning back is not one */
+static int legal(const Snake *s, int a) {
+	return (Direction)(RIGHT + a) != opposite(s->moved);
+}
+
+/* Upper confidence bound choice, unvisited actions first */
+static int select_action(const Search *se, Entry *e, const Snake *s, uint64_t *rng) {
+	double total = log(atomic_load_explicit(&e->visits, memory_order_relaxed) + 1);
+	double best = -1e30;
+	int choice = -1;
+
+	for (int a = 0; a < ACTIONS; a++) {
+		if (!legal(s, a)) {
+			continue;
+		}
+		uint32_t n = atomic_load_explicit(&e->n[a], memory_order_relaxed);
+		double score = n ? atomic_load_explicit(&e->w[a], memory_order_relaxed) / (double)VALUE_ONE / n +
+			se->explore * sqrt(total / n) : 1e9 + (splitmix64(rng) & 0xFFFF);
+
+		if (score > best) {
+			best = score;
+			choice = a;
+		}
+	}
+	return choice;
+}
+
+/* Step with a press, returns the reward of the tick */
+static int play(Snake *s, int a) {
+	unsigned int length = s->length;
+
+	steer_snake(s, (Direction)(RIGHT + a));
+	update_snake(s);
+	return s->state == GAME_OVER ? -2 : s->length > length;
+}
+
+/* Random legal press that does not run into the body when there is one */
+static int rollout_action(const Snake *s, uint64_t r) {
+	int options[ACTIONS], count = 0, safe[ACTIONS], safe_count = 0;
+
+	for (int a = 0; a < ACTIONS; a++) {
+		if (legal(s, a)) {
+			Snake probe;
+
+			options[count++] = a;
+			probe.body[0] = snake_segment(s, 0);
+			probe.head = 0;
+			probe.dir = (Direction)(RIGHT + a);
+			if (!snake_occupies(s, snake_target(&probe)) || snake_target(&probe) == snake_segment(s, s->length - 1)) {
+				safe[safe_count++] = a;
+			}
+		}
+	}
+	return safe_count ? safe[r % safe_count] : options[r % count];
+}
+
+/*
+ * One playout: select down the tree with virtual losses, take the first
+ * position not yet in the table as the new leaf, finish with a random
+ * rollout and add the discounted return to every action on the way.
+ */
+static void playout(Search *se, uint64_t *rng) {
+	Snake s;
+	Entry *path[MAX_DEPTH];
+	int actions[MAX_DEPTH], rewards[MAX_DEPTH + 1], depth = 0;
+
+	memcpy(&s, &se->root, sizeof(s));
+
+	while (depth < MAX_DEPTH && s.state == PLAYING) {
+		Entry *e = lookup(se, zobrist(&s));
+		int a, fresh;
+
+		if (!e) {
+			break;
+		}
+		fresh = atomic_fetch_add_explicit(&e->visits, 1, memory_order_relaxed) == 0;
+		a = select_action(se, e, &s, rng);
+		atomic_fetch_add_explicit(&e->n[a], 1, memory_order_relaxed);
+		atomic_fetch_sub_explicit(&e->w[a], VALUE_ONE, memory_order_relaxed);
+
+		path[depth] = e;
+		actions[depth] = a;
+		rewards[depth] = play(&s, a);
+		depth++;
+		if (fresh) {
+			break;
+		}
+	}
+
+	/* The rollout is worth its discounted rewards, seen from the leaf */
+	double value = 0, discount = 1;
+	for (unsigned int t = 0; t < se->horizon && s.state == PLAYING; t++) {
+		discount *= 0.95;
+		value += discount * play(&s, rollout_action(&s, splitmix64(rng)));
+	}
+
+	for (int i = depth - 1; i >= 0; i--) {
+		value = rewards[i] + 0.95 * value;
+		atomic_fetch_add_explicit(&path[i]->w[actions[i]], (int32_t)(value * VALUE_ONE) + VALUE_ONE,
+			memory_order_relaxed);
+	}
+}
+
+static void search_chunk(void *arg, int worker, uint64_t begin, uint64_t end) {
+	Search *se = arg;
+	uint64_t rng = ((uint64_t)se->move << 32) ^ ((uint64_t)worker << 48) ^ begin;
+
+	for (uint64_t i = begin; i < end; i++) {
+		playout(se, &rng);
+	}
+}
+
+/* Most visited action at the root */
+static int best_action(Search *se) {
+	Entry *e = lookup(se, zobrist(&se->root));
+	uint32_t most = 0;
+	int best = -1;
+
+	for (int a = 0; a < ACTIONS && e; a++) {
+		uint32_t n = atomic_load(&e->n[a]);
+
+		if (legal(&se->root, a) && n > most) {
+			most = n;
+			best = a;
+		}
+	}
+	return best >= 0 ? best : rollout_action(&se->root, 0);
+}
+
+typedef struct {
+	uint64_t playouts;
+	double seconds;
+	double length;
+	unsigned int won, ticks;
+} Result;
+
+static Result run(unsigned int threads, unsigned int games, unsigned int budget, unsigned int max_ticks,
+	unsigned int table_bits, unsigned int horizon) {
+	Search se = { .mask = (1ull << table_bits) - 1, .horizon = horizon, .explore = 1.0 };
+	Result r = { 0 };
+
+	se.table = aligned_alloc(64, sizeof(Entry) << table_bits);
+	memset(se.table, 0, sizeof(Entry) << table_bits);
+
+	for (unsigned int g = 0; g < games; g++) {
+		Snake s;
+		const char *why;
+
+		init_snake(&s, 1 + g);
+		for (unsigned int t = 0; t < max_ticks && s.state == PLAYING; t++) {
+			struct timespec t0, t1;
+
+			memcpy(&se.root, &s, sizeof(s));
+			se.move++;
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			pool_for(budget, threads, 16, search_chunk, &se);
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			r.seconds += seconds(&t0, &t1);
+			r.playouts += budget;
+			r.ticks++;
+
+			play(&s, best_action(&se));
+			if ((why = check_snake(&s))) {
+				fprintf(stderr, "game %u: %s\n", g, why);
+				exit(1);
+			}
+		}
+		r.length += s.length;
+		r.won += s.state == GAME_WON;
+	}
+
+	r.length /= games;
+	free(se.table);
+	return r;
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -j LIST    thread counts (default 1,2,4,... up to all CPUs)\n"
+		"  -g GAMES   games per thread count (default 2)\n"
+		"  -p N       playouts per move (default 1024)\n"
+		"  -t TICKS   tick limit per game (default 500)\n"
+		"  -d TICKS   rollout horizon (default 48)\n"
+		"  -T BITS    log2 of the transposition table entries (default 18)\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int threads[MAX_THREADS], count = 0;
+	unsigned int games = 2, budget = 1024, max_ticks = 500, horizon = 48, table_bits = 18;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:g:p:t:d:T:")) != -1) {
+		switch (opt) {
+			case 'j': {
+				char *p = optarg;
+
+				for (count = 0; count < MAX_THREADS && *p; count++) {
+					threads[count] = strtoul(p, &p, 0);
+					if (*p == ',') p++;
+				}
+				break;
+			}
+			case 'g': games = strtoul(optarg, NULL, 0); break;
+			case 'p': budget = strtoul(optarg, NULL, 0); break;
+			case 't': max_ticks = strtoul(optarg, NULL, 0); break;
+			case 'd': horizon = strtoul(optarg, NULL, 0); break;
+			case 'T': table_bits = strtoul(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+	if (!count) {
+		for (int n = 1; count < MAX_THREADS; n *= 2) {
+			threads[count++] = n < pool_cpus() ? n : pool_cpus();
+			if (n >= pool_cpus()) {
+				break;
+			}
+		}
+	}
+	if (!games || !budget || table_bits < 4 || table_bits > 30) {
+		usage(argv[0]);
+	}
+
+	zobrist_init();
+	printf("Playouts per move %u, rollout horizon %u, table 2^%u entries, %u games of up to %u ticks\n",
+		budget, horizon, table_bits, games, max_ticks);
+	printf("%-8s %14s %12s %10s %6s\n", "threads", "playouts/s", "mean length", "mean ticks", "won");
+	for (unsigned int i = 0; i < count; i++) {
+		if (!threads[i]) {
+			usage(argv[0]);
+		}
+		Result r = run(threads[i], games, budget, max_ticks, table_bits, horizon);
+
+		printf("%-8u %14.0f %12.2f %10.1f %6u\n", threads[i], r.playouts / r.seconds, r.length,
+			(double)r.ticks / games, r.won);
+		fflush(stdout);
+	}
+	return 0;
+}
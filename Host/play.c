@@ -0,0 +1,44 @@
+#include "check.h"
+#include "play.h"
+
+int axis_step(int a, int b, int n) {
+	int d = b - a;
+
+	if (!SNAKE_WALLS) {
+		if (d > n / 2) d -= n;
+		if (d < -n / 2) d += n;
+	}
+	return d;
+}
+
+/* Turn toward the food without running into the body or a wall, when possible */
+Direction greedy_steer(Snake *s, uint32_t r) {
+	static const Direction turns[4] = { RIGHT, DOWN, UP, LEFT };
+	unsigned int head = snake_segment(s, 0), tail = snake_segment(s, s->length - 1);
+	int dr = axis_step(CELL_ROW(head), CELL_ROW(s->food), ROWS);
+	int dc = axis_step(CELL_COL(head), CELL_COL(s->food), COLS);
+	Direction dir = s->dir, best = s->dir;
+	int best_score = -1;
+
+	for (int i = 0; i < 4; i++) {
+		Direction d = turns[(i + r) % 4];
+		unsigned int target;
+		int score;
+
+		if (d == opposite(s->moved)) {
+			continue;
+		}
+		s->dir = d;
+		target = snake_target(s);
+		if (target == CELLS || (snake_occupies(s, target) && target != tail)) {
+			continue;
+		}
+		score = (d == LEFT && dr > 0) || (d == RIGHT && dr < 0) || (d == DOWN && dc > 0) || (d == UP && dc < 0);
+		if (score > best_score) {
+			best_score = score;
+			best = d;
+		}
+	}
+	s->dir = dir;
+	return best;
+}
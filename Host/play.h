@@ -0,0 +1,18 @@
+#ifndef PLAY_H
+#define PLAY_H
+
+#include <stdint.h>
+
+#include "snake.h"
+
+/* Shorter way from a to b along one axis of n cells, negative when it goes down */
+int axis_step(int a, int b, int n);
+
+/*
+ * Turn toward the food without running into the body or a wall when there
+ * is a way, r breaks ties between equally good turns. Works for any board
+ * geometry and edge policy the engine is built for.
+ */
+Direction greedy_steer(Snake *s, uint32_t r);
+
+#endif /* PLAY_H */
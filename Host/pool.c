@@ -0,0 +1,106 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pool.h"
+
+/* Remaining range of one worker, begin in the high and end in the low half */
+typedef struct {
+	_Alignas(64) _Atomic uint64_t range;
+	pthread_t thread;
+} Worker;
+
+typedef struct {
+	Worker *worker;
+	int workers;
+	uint64_t grain;
+	PoolFn fn;
+	void *arg;
+} Pool;
+
+typedef struct {
+	Pool *pool;
+	int id;
+} Start;
+
+#define RANGE(begin, end)	(((uint64_t)(begin) << 32) | (uint32_t)(end))
+#define BEGIN(range)		((range) >> 32)
+#define END(range)			((range) & 0xFFFFFFFFu)
+
+int pool_cpus(void) {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return n > 0 ? (int)n : 1;
+}
+
+/* Take the next chunk from the front of a worker's own range */
+static int take(Pool *p, Worker *w, uint64_t *begin, uint64_t *end) {
+	uint64_t r = atomic_load(&w->range);
+
+	do {
+		if (BEGIN(r) >= END(r)) {
+			return 0;
+		}
+		*begin = BEGIN(r);
+		*end = END(r) - *begin > p->grain ? *begin + p->grain : END(r);
+	} while (!atomic_compare_exchange_weak(&w->range, &r, RANGE(*end, END(r))));
+	return 1;
+}
+
+/* Move the back half of another worker's range into an empty one */
+static int steal(Pool *p, int id) {
+	for (int k = 1; k < p->workers; k++) {
+		Worker *victim = &p->worker[(id + k) % p->workers];
+		uint64_t r = atomic_load(&victim->range);
+
+		while (BEGIN(r) < END(r)) {
+			uint64_t mid = BEGIN(r) + (END(r) - BEGIN(r)) / 2;
+
+			if (atomic_compare_exchange_weak(&victim->range, &r, RANGE(BEGIN(r), mid))) {
+				atomic_store(&p->worker[id].range, RANGE(mid, END(r)));
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static void *run(void *arg) {
+	Start *start = arg;
+	Pool *p = start->pool;
+	Worker *w = &p->worker[start->id];
+	uint64_t begin, end;
+
+	for (;;) {
+		while (take(p, w, &begin, &end)) {
+			p->fn(p->arg, start->id, begin, end);
+		}
+		if (!steal(p, start->id)) {
+			return NULL;
+		}
+	}
+}
+
+void pool_for(uint64_t n, int workers, uint64_t grain, PoolFn fn, void *arg) {
+	Pool p = { .workers = workers > 0 ? workers : 1, .grain = grain ? grain : 1, .fn = fn, .arg = arg };
+	Worker *worker = aligned_alloc(64, sizeof(Worker) * p.workers);
+	Start start[p.workers];
+
+	p.worker = worker;
+	for (int i = 0; i < p.workers; i++) {
+		atomic_init(&worker[i].range, RANGE(n * i / p.workers, n * (i + 1) / p.workers));
+		start[i].pool = &p;
+		start[i].id = i;
+	}
+
+	/* The calling thread works as worker 0 */
+	for (int i = 1; i < p.workers; i++) {
+		pthread_create(&worker[i].thread, NULL, run, &start[i]);
+	}
+	run(&start[0]);
+	for (int i = 1; i < p.workers; i++) {
+		pthread_join(worker[i].thread, NULL);
+	}
+	free(worker);
+}
@@ -0,0 +1,20 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+
+/* Body of a parallel loop, called with consecutive chunks of the index range */
+typedef void (*PoolFn)(void *arg, int worker, uint64_t begin, uint64_t end);
+
+/* Number of online CPUs */
+int pool_cpus(void);
+
+/*
+ * Run fn over [0, n) on a number of worker threads. Every worker starts with
+ * an equal share of the range and takes chunks of grain indices from its
+ * front; a worker that runs dry steals the back half of another worker's
+ * remaining range. n must fit in 32 bits.
+ */
+void pool_for(uint64_t n, int workers, uint64_t grain, PoolFn fn, void *arg);
+
+#endif /* POOL_H */
@@ -0,0 +1,269 @@
+/*
+ * Interrupt preemption race explorer. PORTE_IRQHandler() queues presses
+ * and preempts the game tick, which takes them and records the game with
+ * record_steer() and record_update() as main.c does. The main loop runs
+ * the game tick and the refresh one after the other, so the press queue
+ * (Sources/presses.h) is the only memory a handler shares with them. For
+ * many game states with presses queued this runs the game tick with a
+ * press injected at every race point of the press queue. After each
+ * interleaving it checks the engine invariants, that the tick took the
+ * presses in order and reached the state of a tick run alone.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "frame.h"
+#include "pool.h"
+#include "presses.h"
+#include "replay.h"
+#include "tools.h"
+
+#define MAX_FAILURES 16
+
+/* What an interleaving got wrong */
+enum { INVARIANT, LOST_PRESS, NOT_SERIAL, KINDS };
+
+static const char *const kind_names[KINDS] = {
+	"engine invariant broken", "press lost or out of order", "state differs from the tick run alone"
+};
+
+/* One interleaving, reached by the race point through the thread */
+typedef struct {
+	Snake snake;
+	Replay replay;
+	Frame frame;
+	PressQueue queue;
+	Direction press;				/* Press of the injected button handler */
+	int press_at;					/* Race point of the game tick at which the press comes, -1 for none */
+	int tick_points;
+	int pressed;
+	Direction taken[PRESS_QUEUE + 1];/* Presses the game tick took */
+	unsigned int ntaken;
+} Run;
+
+static _Thread_local Run *run;
+
+/* Results of one worker, merged when all states are done */
+typedef struct {
+	_Alignas(64) uint64_t states, interleavings;
+	uint64_t failures[KINDS];
+	uint64_t listed;					/* Failures listed, the first of each kind per state */
+	uint64_t failed_state[MAX_FAILURES];
+	int failed_press[MAX_FAILURES], failed_kind[MAX_FAILURES];
+} Stats;
+
+typedef struct {
+	uint64_t base;
+	Stats *stats;
+} Explore;
+
+/* A race point of the game tick is where PORTE_IRQHandler() can preempt it */
+void race_point(void) {
+	if (run && run->tick_points++ == run->press_at) {
+		run->pressed = press_put(&run->queue, run->press);
+	}
+}
+
+/* game_tick() of main.c for a player on the open board, the firmware calls between the race points */
+static void game_tick(Run *r) {
+	Direction dir;
+
+	while (press_take(&r->queue, &dir)) {
+		r->taken[r->ntaken++] = dir;
+		record_steer(&r->replay, &r->snake, dir, 0);
+	}
+	record_update(&r->replay, &r->snake);
+	frame_publish(&r->frame, &r->snake);
+}
+
+/* A game state some way into a random game, with presses waiting in the queue */
+static void make_state(uint64_t seed, Run *r) {
+	uint64_t rng = seed;
+	unsigned int ticks = splitmix64(&rng) % 400;
+
+	memset(r, 0, sizeof(*r));
+	record_init(&r->replay);
+	record_start(&r->replay, &r->snake, (uint32_t)splitmix64(&rng), 0);
+	for (unsigned int t = 0; t < ticks && r->snake.state == PLAYING; t++) {
+		if (splitmix64(&rng) % 3 == 0) {
+			record_steer(&r->replay, &r->snake, (Direction)(RIGHT + splitmix64(&rng) % 4), 0);
+		}
+		record_update(&r->replay, &r->snake);
+	}
+	for (unsigned int n = splitmix64(&rng) % (PRESS_QUEUE + 1); n; n--) {
+		uint64_t p = splitmix64(&rng);
+
+		press_put(&r->queue, p % 16 == 0 ? STOP : (Direction)(RIGHT + p % 4));
+	}
+	r->press = (Direction)(splitmix64(&rng) % 5);
+}
+
+static int check(const Run *start, const Run *r) {
+	Snake alone = start->snake;
+	Direction queued[PRESS_QUEUE + 1];
+	unsigned int n = 0;
+
+	if (check_snake(&r->snake)) {
+		return INVARIANT;
+	}
+
+	/* What was queued, then the press if it found room, is what was taken and what is left */
+	for (unsigned int i = start->queue.out; i != start->queue.in; i++) {
+		queued[n++] = (Direction)start->queue.dir[i % PRESS_QUEUE];
+	}
+	if (r->pressed) {
+		queued[n++] = r->press;
+	}
+	if (r->ntaken + (r->queue.in - r->queue.out) != n) {
+		return LOST_PRESS;
+	}
+	for (unsigned int i = 0; i < n; i++) {
+		unsigned int left = r->queue.out + i - r->ntaken;
+		Direction d = i < r->ntaken ? r->taken[i] : (Direction)r->queue.dir[left % PRESS_QUEUE];
+
+		if (d != queued[i]) {
+			return LOST_PRESS;
+		}
+	}
+
+	/* The tick must end where the same presses applied without preemption lead */
+	for (unsigned int i = 0; i < r->ntaken; i++) {
+		steer_snake(&alone, r->taken[i]);
+	}
+	update_snake(&alone);
+	if (snake_hash(&alone) != snake_hash(&r->snake) ||
+		memcmp(alone.occupied, r->snake.occupied, sizeof(alone.occupied))) {
+		return NOT_SERIAL;
+	}
+	return -1;
+}
+
+/* Counts a failure, listing the first interleaving of each kind per state */
+static void fail(Stats *st, uint64_t state, const Run *r, int kind, unsigned int *seen) {
+	if (st->listed < MAX_FAILURES && !(*seen & (1u << kind))) {
+		st->failed_state[st->listed] = state;
+		st->failed_press[st->listed] = r->press_at;
+		st->failed_kind[st->listed] = kind;
+		st->listed++;
+	}
+	*seen |= 1u << kind;
+	st->failures[kind]++;
+}
+
+/* Every interleaving of one state */
+static void explore(uint64_t state, Stats *st) {
+	Run start, r;
+	unsigned int seen = 0;
+	int points;
+
+	make_state(state, &start);
+
+	/* Count the race points of a tick run alone */
+	r = start;
+	r.press_at = -1;
+	run = &r;
+	game_tick(&r);
+	points = r.tick_points;
+
+	for (int press_at = -1; press_at < points; press_at++) {
+		int kind;
+
+		r = start;
+		r.press_at = press_at;
+		game_tick(&r);
+		st->interleavings++;
+		if ((kind = check(&start, &r)) >= 0) {
+			fail(st, state, &r, kind, &seen);
+		}
+	}
+	st->states++;
+	run = NULL;
+}
+
+static void explore_chunk(void *arg, int worker, uint64_t begin, uint64_t end) {
+	Explore *e = arg;
+
+	for (uint64_t i = begin; i < end; i++) {
+		explore(e->base + i, &e->stats[worker]);
+	}
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n STATES  game states to explore (default 10000)\n"
+		"  -b SEED    seed of the first state (default 1)\n"
+		"  -j N       worker threads (default all CPUs)\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	uint64_t states = 10000;
+	int workers = pool_cpus(), opt;
+	Explore e = { .base = 1 };
+
+	while ((opt = getopt(argc, argv, "n:b:j:")) != -1) {
+		switch (opt) {
+			case 'n': states = strtoull(optarg, NULL, 0); break;
+			case 'b': e.base = strtoull(optarg, NULL, 0); break;
+			case 'j': workers = atoi(optarg); break;
+			default: usage(argv[0]);
+		}
+	}
+	if (workers < 1 || states > UINT32_MAX) {
+		usage(argv[0]);
+	}
+
+	e.stats = aligned_alloc(64, sizeof(Stats) * workers);
+	memset(e.stats, 0, sizeof(Stats) * workers);
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	pool_for(states, workers, 16, explore_chunk, &e);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double elapsed = seconds(&t0, &t1);
+
+	/* Merge the per-worker results */
+	Stats total;
+	memset(&total, 0, sizeof(total));
+	for (int w = 0; w < workers; w++) {
+		const Stats *st = &e.stats[w];
+
+		total.states += st->states;
+		total.interleavings += st->interleavings;
+		for (int k = 0; k < KINDS; k++) {
+			total.failures[k] += st->failures[k];
+		}
+		for (uint64_t i = 0; i < st->listed && i < MAX_FAILURES; i++) {
+			uint64_t at = total.listed + i;
+
+			if (at < MAX_FAILURES) {
+				total.failed_state[at] = st->failed_state[i];
+				total.failed_press[at] = st->failed_press[i];
+				total.failed_kind[at] = st->failed_kind[i];
+			}
+		}
+		total.listed += st->listed;
+	}
+
+	printf("Explored:     %" PRIu64 " states, %" PRIu64 " interleavings on %d threads in %.2f s\n", total.states,
+		total.interleavings, workers, elapsed);
+	printf("Throughput:   %.0f interleavings/s\n", total.interleavings / elapsed);
+	for (int k = 0; k < KINDS; k++) {
+		printf("  %-40s %" PRIu64 "\n", kind_names[k], total.failures[k]);
+	}
+	for (uint64_t i = 0; i < total.listed && i < MAX_FAILURES; i++) {
+		printf("  state %" PRIu64 ", press at race point %d of the game tick: %s\n",
+			total.failed_state[i], total.failed_press[i], kind_names[total.failed_kind[i]]);
+	}
+
+	free(e.stats);
+	return total.listed ? 1 : 0;
+}
@@ -0,0 +1,374 @@
+/*
+ * Exhaustive reachability check of the game engine on a small board. Every
+ * state reachable from a new game under any sequence of button presses and
+ * game ticks is visited once, breadth first and in parallel, and each one
+ * is checked against the engine invariants. The food generator is replaced
+ * by a choice of every free cell, so the checked states are a superset of
+ * what any seed can reach.
+ *
+ * The board wraps around, so the engine commutes with translations: states
+ * are stored moved so that the head is in cell 0, which divides their number
+ * by CELLS. The direction saved for STOP is cleared while the snake moves,
+ * as the next STOP press overwrites it unread.
+ *
+ * Built once per geometry with ROWS, COLS and SNAKE_LENGTH defined.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "pool.h"
+#include "snake.h"
+
+/* A state packs into one word: length, food, flags and a 2-bit step per segment */
+#define CELL_BITS	(CELLS <= 16 ? 4 : CELLS <= 32 ? 5 : CELLS <= 64 ? 6 : 7)
+#define LENGTH_BITS	(CELLS < 16 ? 4 : CELLS < 32 ? 5 : CELLS < 64 ? 6 : 7)
+#define STATE_BITS	(CELL_BITS + LENGTH_BITS + 2 + 3 + 3 + 2 + 2 * (CELLS - 1))
+#define VALID		(1ull << 63)	/* Keeps every encoded state non-zero */
+
+_Static_assert(STATE_BITS <= 63, "board too large for the state encoding");
+
+#define SHARDS 256
+
+/* One shard of the visited set, open addressing behind its own lock */
+typedef struct {
+	_Alignas(64) pthread_mutex_t lock;
+	uint64_t *slot;
+	uint64_t capacity, count;
+} Shard;
+
+/* New states found by one worker during a level */
+typedef struct {
+	_Alignas(64) uint64_t *state;
+	uint64_t count, capacity;
+	uint64_t transitions;
+} Found;
+
+typedef struct {
+	Shard shard[SHARDS];
+	const uint64_t *frontier;
+	Found *found;
+	unsigned int max_length;			/* States longer than this are checked but not expanded */
+	_Atomic int failed;
+} Reach;
+
+static uint64_t mix(uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDull;
+	x ^= x >> 33;
+	x *= 0xC4CEB9FE1A85EC53ull;
+	return x ^ (x >> 33);
+}
+
+/* Add a state to the visited set, returns whether it is new */
+static int visit(Reach *r, uint64_t key) {
+	uint64_t h = mix(key);
+	Shard *sh = &r->shard[h >> 56];
+	int fresh = 0;
+
+	pthread_mutex_lock(&sh->lock);
+	for (uint64_t i = h & (sh->capacity - 1);; i = (i + 1) & (sh->capacity - 1)) {
+		if (sh->slot[i] == key) {
+			break;
+		}
+		if (!sh->slot[i]) {
+			sh->slot[i] = key;
+			fresh = 1;
+			break;
+		}
+	}
+
+	/* Double at half full, rehashing under the same lock */
+	if (fresh && ++sh->count * 2 > sh->capacity) {
+		uint64_t capacity = sh->capacity * 2, *slot = calloc(capacity, sizeof(uint64_t));
+
+		if (!slot) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		for (uint64_t j = 0; j < sh->capacity; j++) {
+			if (sh->slot[j]) {
+				uint64_t k = mix(sh->slot[j]) & (capacity - 1);
+
+				while (slot[k]) {
+					k = (k + 1) & (capacity - 1);
+				}
+				slot[k] = sh->slot[j];
+			}
+		}
+		free(sh->slot);
+		sh->slot = slot;
+		sh->capacity = capacity;
+	}
+	pthread_mutex_unlock(&sh->lock);
+	return fresh;
+}
+
+/* Step from cell a to the neighbouring cell b, 0 to 3 */
+static unsigned int step_code(unsigned int a, unsigned int b) {
+	unsigned int dr = (CELL_ROW(b) + ROWS - CELL_ROW(a)) % ROWS;
+	unsigned int dc = (CELL_COL(b) + COLS - CELL_COL(a)) % COLS;
+
+	return dc == 0 ? (dr == 1 ? 0 : 1) : (dc == 1 ? 2 : 3);
+}
+
+static unsigned int step_cell(unsigned int a, unsigned int code) {
+	unsigned int row = CELL_ROW(a), col = CELL_COL(a);
+
+	switch (code) {
+		case 0: row = (row + 1) % ROWS; break;
+		case 1: row = (row + ROWS - 1) % ROWS; break;
+		case 2: col = (col + 1) % COLS; break;
+		default: col = (col + COLS - 1) % COLS; break;
+	}
+	return CELL(row, col);
+}
+
+/* Cell c moved by the inverse of the translation that takes cell origin to cell 0 */
+static unsigned int translate(unsigned int c, unsigned int origin) {
+	return CELL((CELL_ROW(c) + ROWS - CELL_ROW(origin)) % ROWS, (CELL_COL(c) + COLS - CELL_COL(origin)) % COLS);
+}
+
+/*
+ * Pack a state that passed check_snake(), relative to its head. The ring
+ * position and the seed are left out.
+ */
+static uint64_t encode(const Snake *s) {
+	uint64_t x = VALID;
+	unsigned int at = 0, head = snake_segment(s, 0);
+
+#define PUT(value, bits) (x |= (uint64_t)(value) << at, at += (bits))
+	PUT(s->length, LENGTH_BITS);
+	PUT(translate(s->food % CELLS, head), CELL_BITS);
+	PUT(s->state, 2);
+	PUT(s->dir, 3);
+	PUT(s->dir == STOP ? s->dir_before_stop : STOP, 3);
+	PUT(s->moved - RIGHT, 2);
+	for (unsigned int i = 1; i < s->length; i++) {
+		PUT(step_code(snake_segment(s, i - 1), snake_segment(s, i)), 2);
+	}
+#undef PUT
+	return x;
+}
+
+static void decode(uint64_t x, Snake *s) {
+	unsigned int at = 0;
+
+#define GET(bits) (at += (bits), (unsigned int)((x >> (at - (bits))) & ((1ull << (bits)) - 1)))
+	unsigned int cell = 0;
+
+	memset(s, 0, sizeof(*s));
+	s->length = GET(LENGTH_BITS);
+	s->food = GET(CELL_BITS);
+	s->state = (GameState)GET(2);
+	s->dir = (Direction)GET(3);
+	s->dir_before_stop = (Direction)GET(3);
+	s->moved = (Direction)(RIGHT + GET(2));
+	s->seed = 1;
+	s->head = s->length - 1;
+	for (unsigned int i = 0; i < s->length; i++) {
+		if (i) {
+			cell = step_cell(cell, GET(2));
+		}
+		s->body[s->head - i] = cell;
+		s->occupied[cell / 64] |= 1ull << (cell % 64);
+	}
+#undef GET
+}
+
+static void report(Reach *r, const Snake *from, const char *how, const Snake *to, const char *why) {
+	if (atomic_exchange(&r->failed, 1)) {
+		return;
+	}
+	printf("VIOLATION: %s after %s\n", why, how);
+	printf("  from: head %u length %u food %u state %d dir %d before stop %d moved %d\n",
+		snake_segment(from, 0), from->length, from->food, from->state, from->dir, from->dir_before_stop, from->moved);
+	printf("  to:   head %u length %u food %u state %d dir %d before stop %d moved %d\n",
+		snake_segment(to, 0), to->length, to->food, to->state, to->dir, to->dir_before_stop, to->moved);
+}
+
+static void push(Found *f, uint64_t state) {
+	if (f->count == f->capacity) {
+		f->capacity = f->capacity ? f->capacity * 2 : 4096;
+		if (!(f->state = realloc(f->state, f->capacity * sizeof(uint64_t)))) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	f->state[f->count++] = state;
+}
+
+/* Check a successor and queue it if new; a freshly placed food may land on any free cell */
+static void successor(Reach *r, Found *f, const Snake *from, const char *how, Snake *to, int any_food) {
+	unsigned int first = 0, last = 0;
+	const char *why;
+
+	if (any_food && to->state == PLAYING) {
+		last = CELLS - 1;
+	} else {
+		first = last = to->food;
+	}
+	for (unsigned int food = first; food <= last; food++) {
+		to->food = food;
+		if (any_food && to->state == PLAYING && snake_occupies(to, food)) {
+			continue;
+		}
+		f->transitions++;
+		if ((why = check_snake(to))) {
+			report(r, from, how, to, why);
+			return;
+		}
+
+		uint64_t key = encode(to);
+		if (visit(r, key)) {
+			push(f, key);
+		}
+	}
+}
+
+static const char *press_name[5] = { "STOP press", "RIGHT press", "DOWN press", "UP press", "LEFT press" };
+
+static void expand(void *arg, int worker, uint64_t begin, uint64_t end) {
+	Reach *r = arg;
+	Found *f = &r->found[worker];
+
+	for (uint64_t i = begin; i < end && !atomic_load_explicit(&r->failed, memory_order_relaxed); i++) {
+		Snake s, t;
+
+		decode(r->frontier[i], &s);
+		if (s.length > r->max_length) {
+			continue;
+		}
+
+		/* A press on an ended game starts a new one, which places food */
+		for (int dir = STOP; dir <= LEFT; dir++) {
+			t = s;
+			steer_snake(&t, (Direction)dir);
+			successor(r, f, &s, press_name[dir], &t, s.state != PLAYING);
+		}
+
+		t = s;
+		update_snake(&t);
+		successor(r, f, &s, "tick", &t, t.length > s.length);
+	}
+}
+
+static double now(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -j N       worker threads (default all CPUs)\n"
+		"  -l LENGTH  do not expand states of a longer snake (default no limit)\n"
+		"  -v         print every BFS level\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	int workers = pool_cpus(), verbose = 0, opt;
+	unsigned int max_length = CELLS;
+
+	while ((opt = getopt(argc, argv, "j:l:v")) != -1) {
+		switch (opt) {
+			case 'j': workers = atoi(optarg); break;
+			case 'l': max_length = strtoul(optarg, NULL, 0); break;
+			case 'v': verbose = 1; break;
+			default: usage(argv[0]);
+		}
+	}
+	if (workers < 1) {
+		usage(argv[0]);
+	}
+
+	Reach *r = calloc(1, sizeof(Reach));
+	r->max_length = max_length;
+	r->found = aligned_alloc(64, sizeof(Found) * workers);
+	memset(r->found, 0, sizeof(Found) * workers);
+	for (int i = 0; i < SHARDS; i++) {
+		pthread_mutex_init(&r->shard[i].lock, NULL);
+		r->shard[i].capacity = 1024;
+		r->shard[i].slot = calloc(r->shard[i].capacity, sizeof(uint64_t));
+	}
+
+	printf("Board:        %dx%d, start length %d, %d bit states", COLS, ROWS, SNAKE_LENGTH, STATE_BITS);
+	if (max_length < CELLS) {
+		printf(", expanded up to length %u", max_length);
+	}
+	printf("\n");
+
+	/* Level 0: a new game with the food on any free cell */
+	Snake start;
+	init_snake(&start, 1);
+	successor(r, &r->found[0], &start, "reset", &start, 1);
+
+	uint64_t states = 0, transitions = 0, peak_frontier = 0, *frontier = NULL;
+	unsigned int level = 0;
+	double t0 = now();
+
+	for (;;) {
+		uint64_t count = 0;
+
+		for (int w = 0; w < workers; w++) {
+			count += r->found[w].count;
+		}
+		if (!count || atomic_load(&r->failed)) {
+			break;
+		}
+
+		/* The states found by all workers make the next frontier */
+		free(frontier);
+		frontier = malloc(count * sizeof(uint64_t));
+		count = 0;
+		for (int w = 0; w < workers; w++) {
+			memcpy(frontier + count, r->found[w].state, r->found[w].count * sizeof(uint64_t));
+			count += r->found[w].count;
+			r->found[w].count = 0;
+		}
+		states += count;
+		peak_frontier = count > peak_frontier ? count : peak_frontier;
+
+		if (verbose) {
+			fprintf(stderr, "level %u: %" PRIu64 " new states, %" PRIu64 " total, %.1f s\n",
+				level, count, states, now() - t0);
+		}
+
+		r->frontier = frontier;
+		pool_for(count, workers, 1024, expand, r);
+		level++;
+	}
+	double elapsed = now() - t0;
+
+	uint64_t table = 0;
+	for (int i = 0; i < SHARDS; i++) {
+		table += r->shard[i].capacity * sizeof(uint64_t);
+	}
+	for (int w = 0; w < workers; w++) {
+		transitions += r->found[w].transitions;
+	}
+
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+
+	printf("States:       %" PRIu64 " reachable in %u levels, %" PRIu64 " transitions checked\n",
+		states, level, transitions);
+	printf("Time:         %.2f s on %d threads, %.2f M states/s, %.2f M transitions/s\n",
+		elapsed, workers, states / elapsed * 1e-6, transitions / elapsed * 1e-6);
+	printf("Memory:       %.1f MB visited set, %.1f MB largest frontier, %.1f MB peak resident\n",
+		table / 1048576.0, peak_frontier * sizeof(uint64_t) / 1048576.0, ru.ru_maxrss / 1024.0);
+	printf("Result:       %s\n", atomic_load(&r->failed) ? "FAILED" : "no reachable state violates the invariants");
+	return atomic_load(&r->failed);
+}
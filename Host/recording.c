@@ -0,0 +1,59 @@
+#include "level.h"
+#include "recording.h"
+
+/* Reads a varint, returns 0 when the stream ends inside it */
+static int get_varint(const uint8_t **p, const uint8_t *end, uint64_t *x) {
+	*x = 0;
+	for (unsigned int shift = 0; *p < end && shift < 64; shift += 7) {
+		uint8_t b = *(*p)++;
+
+		*x |= (uint64_t)(b & 0x7F) << shift;
+		if (!(b & 0x80)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+const char *recording_header(const uint8_t *p, size_t size) {
+	if (size < RECORDING_HEADER || p[0] != 'S' || p[1] != 'N' || p[2] != 'K' || p[3] != 'R') {
+		return "not a recording";
+	}
+	if (p[4] != REPLAY_VERSION || p[5] != COLS || p[6] != ROWS) {
+		return "recorded by another version or for another board";
+	}
+	return NULL;
+}
+
+const char *recording_next(const uint8_t **p, const uint8_t *end, Record *r) {
+	uint64_t v;
+
+	if (!get_varint(p, end, &v)) {
+		return "stream ends inside a record";
+	}
+	r->ticks = v >> 3;
+	r->code = v & 7;
+
+	switch (r->code) {
+		case STOP: case RIGHT: case DOWN: case UP: case LEFT:
+			return NULL;
+		case REPLAY_START:
+			if (!get_varint(p, end, &v) || *p == end) {
+				return "stream ends inside a start";
+			}
+			r->seed = (uint32_t)v;
+			r->level = *(*p)++;
+			return r->level > level_count ? "unknown level" : NULL;
+		case REPLAY_END:
+			if (end - *p < 4) {
+				return "stream ends inside an end";
+			}
+			r->hash = 0;
+			for (int i = 0; i < 4; i++) {
+				r->hash |= (uint32_t)*(*p)++ << (i * 8);
+			}
+			return NULL;
+		default:
+			return "unknown record";
+	}
+}
@@ -0,0 +1,27 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "replay.h"
+
+/* Bytes of the stream header, "SNKR", version, columns and rows */
+#define RECORDING_HEADER 7
+
+/* One decoded record of a recording */
+typedef struct {
+	uint64_t ticks;				/* Ticks since the previous record */
+	unsigned int code;			/* Direction, REPLAY_START or REPLAY_END */
+	uint32_t seed;				/* Seed of a start */
+	unsigned int level;			/* Level number of a start, 0 for the open board */
+	uint32_t hash;				/* snake_hash() of an end */
+} Record;
+
+/* Checks the header of a stream for this engine, returns NULL or what is wrong */
+const char *recording_header(const uint8_t *p, size_t size);
+
+/* Decodes the record at *p and moves past it, returns NULL or what is wrong */
+const char *recording_next(const uint8_t **p, const uint8_t *end, Record *r);
+
+#endif /* RECORDING_H */
@@ -0,0 +1,227 @@
+/*
+ * Replays recordings of the board (Sources/replay.h) through the engine as
+ * fast as it runs and checks the hash of every finished game. With -w it
+ * records games of a simulated player instead, through the same recorder
+ * the firmware uses.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "level.h"
+#include "play.h"
+#include "recording.h"
+#include "replay.h"
+#include "snake.h"
+#include "tools.h"
+
+typedef struct {
+	uint64_t games, checked, mismatched, ticks, steps, records;
+} Totals;
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options] FILE...\n"
+		"  -w FILE    record games of a simulated player into FILE instead\n"
+		"  -g GAMES   games to record (default 1000)\n"
+		"  -l LEVEL   level to record on, 1 to %u, 0 for the open board (default 0)\n"
+		"  -s SEED    seed of the first recorded game (default 1)\n"
+		"  -v         print every finished game\n",
+		prog, level_count);
+	exit(2);
+}
+
+/*
+ * Replays one stream, returns NULL or what is wrong with it. The engine
+ * does nothing on a tick while the game is paused or over, so those ticks
+ * are skipped rather than run.
+ */
+static const char *replay(const uint8_t *p, size_t size, Totals *t, int verbose, const char *name) {
+	const uint8_t *end = p + size;
+	const char *why;
+	uint64_t tick = 0;
+	int started = 0;
+	Record r;
+	Snake s;
+
+	if ((why = recording_header(p, size))) {
+		return why;
+	}
+	p += RECORDING_HEADER;
+
+	while (p < end) {
+		if ((why = recording_next(&p, end, &r))) {
+			return why;
+		}
+		t->records++;
+
+		uint64_t until = tick + r.ticks;
+		t->ticks += r.ticks;
+		if (started) {
+			while (tick < until && s.state == PLAYING && s.dir != STOP) {
+				update_snake(&s);
+				tick++;
+				t->steps++;
+			}
+		} else if (r.code != REPLAY_START) {
+			return "record before the first start";
+		}
+		tick = until;
+
+		switch (r.code) {
+			case REPLAY_START:
+				init_level(&s, r.seed, r.level ? levels[r.level - 1] : NULL);
+				started = 1;
+				t->games++;
+				break;
+			case REPLAY_END:
+				t->checked++;
+				if (s.state == PLAYING || snake_hash(&s) != r.hash) {
+					t->mismatched++;
+					printf("%s: game ending at tick %" PRIu64 " differs, recorded %08x, replayed %08x %s\n", name,
+						tick, r.hash, snake_hash(&s), s.state == PLAYING ? "still playing" : "");
+				} else if (verbose) {
+					printf("%s: game ended at tick %" PRIu64 ", length %u, %s\n", name, tick, s.length,
+						s.state == GAME_WON ? "won" : "over");
+				}
+				break;
+			default:
+				steer_snake(&s, (Direction)r.code);
+				break;
+		}
+	}
+	return NULL;
+}
+
+/* Moves what the recorder wrote to the file, as the debugger does on the board */
+static int drain(Replay *r, FILE *f) {
+	while (r->read != r->written) {
+		if (fputc(r->data[r->read % REPLAY_BYTES], f) == EOF) {
+			return -1;
+		}
+		r->read++;
+	}
+	return 0;
+}
+
+/*
+ * A player who turns toward the food now and then, pauses for a while on
+ * rare occasions and takes a few ticks to start the next game.
+ */
+static int record(const char *path, uint64_t games, unsigned int level, uint32_t seed) {
+	static Replay rec;
+	FILE *f = fopen(path, "wb");
+	uint64_t played = 0, ticks = 0;
+	uint32_t r = seed;
+	unsigned int wait = 0;
+	Snake s;
+
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+	record_init(&rec);
+	record_start(&rec, &s, seed, level);
+	while (played < games) {
+		if (wait) {
+			wait--;
+		} else if (s.state != PLAYING) {
+			record_steer(&rec, &s, (Direction)(RIGHT + xorshift(&r) % 4), level);
+		} else if (s.dir == STOP) {
+			record_steer(&rec, &s, STOP, level);
+		} else if (xorshift(&r) % 512 == 0) {
+			record_steer(&rec, &s, STOP, level);
+			wait = xorshift(&r) % 64;
+		} else if (xorshift(&r) % 4 == 0) {
+			record_steer(&rec, &s, greedy_steer(&s, xorshift(&r)), level);
+		}
+
+		GameState state = s.state;
+		record_update(&rec, &s);
+		ticks++;
+		if (state == PLAYING && s.state != PLAYING) {
+			played++;
+			wait = xorshift(&r) % 32;
+		}
+		if (drain(&rec, f)) {
+			perror(path);
+			fclose(f);
+			return 1;
+		}
+	}
+
+	long bytes = ftell(f);
+	if (fclose(f)) {
+		perror(path);
+		return 1;
+	}
+	printf("Recorded:     %" PRIu64 " games in %" PRIu64 " ticks, %ld bytes, %.1f bytes per game, %u dropped\n",
+		played, ticks, bytes, (double)bytes / played, rec.dropped);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	const char *out = NULL;
+	uint64_t games = 1000;
+	unsigned int level = 0;
+	uint32_t seed = 1;
+	int opt, verbose = 0, bad = 0;
+
+	while ((opt = getopt(argc, argv, "w:g:l:s:v")) != -1) {
+		switch (opt) {
+			case 'w': out = optarg; break;
+			case 'g': games = strtoull(optarg, NULL, 0); break;
+			case 'l': level = strtoul(optarg, NULL, 0); break;
+			case 's': seed = strtoul(optarg, NULL, 0); break;
+			case 'v': verbose = 1; break;
+			default: usage(argv[0]);
+		}
+	}
+	if (level > level_count || (out ? optind != argc : optind == argc)) {
+		usage(argv[0]);
+	}
+	if (out) {
+		return record(out, games, level, seed ? seed : 1);
+	}
+
+	Totals t = { 0 };
+	struct timespec t0, t1;
+	double busy = 0;
+
+	for (int i = optind; i < argc; i++) {
+		FILE *f = fopen(argv[i], "rb");
+		uint8_t *data;
+		long size;
+		const char *why;
+
+		if (!f || fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET)) {
+			perror(argv[i]);
+			return 1;
+		}
+		if (!(data = malloc(size ? size : 1)) || fread(data, 1, size, f) != (size_t)size) {
+			perror(argv[i]);
+			return 1;
+		}
+		fclose(f);
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		why = replay(data, size, &t, verbose, argv[i]);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		busy += seconds(&t0, &t1);
+		if (why) {
+			printf("%s: %s\n", argv[i], why);
+			bad = 1;
+		}
+		free(data);
+	}
+
+	printf("Replayed:     %" PRIu64 " games, %" PRIu64 " records, %" PRIu64 " ticks\n", t.games, t.records, t.ticks);
+	printf("Checked:      %" PRIu64 " finished games, %" PRIu64 " differ\n", t.checked, t.mismatched);
+	printf("Speed:        %.1f M recorded ticks/s, %.1f M engine steps/s\n", t.ticks / busy * 1e-6,
+		t.steps / busy * 1e-6);
+	return bad || t.mismatched;
+}
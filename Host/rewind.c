@@ -0,0 +1,140 @@
+/*
+ * Time travel over a long simulated run. A player presses buttons on the
+ * simulated board for a number of game ticks while the run keeps a ring of
+ * snapshots, then random seeks into the window the ring covers are timed
+ * and compared against copies of the board the run kept at some ticks.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "play.h"
+#include "tools.h"
+#include "travel.h"
+
+#define CHECKS 16
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -t TICKS   game ticks to run (default 20000)\n"
+		"  -n TICKS   game ticks between snapshots (default 100)\n"
+		"  -m SLOTS   snapshots kept (default 64)\n"
+		"  -k SEEKS   random seeks to time (default 1000)\n"
+		"  -s SEED    seed of the player (default 1)\n",
+		prog);
+	exit(2);
+}
+
+/* A player who turns toward the food on some ticks and starts the next game after a while */
+static void player(Travel *t, uint32_t *r) {
+	Snake s = t->run.snake;
+	uint64_t at = t->run.now + xorshift(r) % t->run.event_period[EVENT_TICK];
+
+	if (xorshift(r) % 3) {
+		return;
+	}
+	if (s.state != PLAYING) {
+		travel_press(t, at, (Direction)(RIGHT + xorshift(r) % 4));
+	} else {
+		travel_press(t, at, greedy_steer(&s, xorshift(r)));
+	}
+}
+
+int main(int argc, char *argv[]) {
+	uint64_t ticks = 20000, interval = 100, seeks = 1000;
+	unsigned int slots = 64;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:n:m:k:s:")) != -1) {
+		switch (opt) {
+			case 't': ticks = strtoull(optarg, NULL, 0); break;
+			case 'n': interval = strtoull(optarg, NULL, 0); break;
+			case 'm': slots = strtoul(optarg, NULL, 0); break;
+			case 'k': seeks = strtoull(optarg, NULL, 0); break;
+			case 's': seed = strtoul(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+	if (!ticks || !interval || !slots || !seed) {
+		usage(argv[0]);
+	}
+
+	static Travel t;
+	static Sim copy[CHECKS];
+	uint64_t check_tick[CHECKS], window = ticks < (uint64_t)slots * interval ? 0 : ticks - (slots - 1) * interval;
+	SimConfig cfg;
+	uint32_t r = seed;
+	struct timespec t0, t1;
+
+	sim_default_config(&cfg);
+	if (travel_init(&t, &cfg, interval, slots)) {
+		perror("travel_init");
+		return 1;
+	}
+
+	/* Ticks inside the window the ring will cover at the end, where the run keeps a copy */
+	for (int i = 0; i < CHECKS; i++) {
+		check_tick[i] = window + xorshift(&r) % (ticks - window + 1);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint64_t tick = 1; tick <= ticks; tick++) {
+		travel_run(&t, travel_tick_time(&t, tick));
+		player(&t, &r);
+		for (int i = 0; i < CHECKS; i++) {
+			if (check_tick[i] == tick) {
+				copy[i] = t.run;
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double run = seconds(&t0, &t1);
+
+	/* Random seeks anywhere in the window */
+	double total = 0, worst = 0;
+	uint64_t missed = 0;
+	for (uint64_t i = 0; i < seeks; i++) {
+		uint64_t tick = window + xorshift(&r) % (ticks - window + 1);
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		const Sim *v = travel_seek(&t, tick);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		double s = seconds(&t0, &t1);
+		total += s;
+		if (s > worst) {
+			worst = s;
+		}
+		missed += !v;
+	}
+
+	/* Every check tick once more, compared with the copy the run kept */
+	unsigned int differ = 0;
+	for (int i = 0; i < CHECKS; i++) {
+		const Sim *v = travel_seek(&t, check_tick[i]);
+
+		if (!v || memcmp(v, &copy[i], sizeof(Sim))) {
+			printf("tick %" PRIu64 ": the seek does not reproduce the run\n", check_tick[i]);
+			differ++;
+		}
+	}
+
+	printf("Run:          %" PRIu64 " game ticks, %.1f s simulated in %.2f s, %.1f us per tick\n", ticks,
+		(double)t.run.now / cfg.core_hz, run, run / ticks * 1e6);
+	printf("Snapshots:    every %" PRIu64 " ticks, %u kept, window from tick %" PRIu64 "\n", interval, t.count,
+		window);
+	printf("Memory:       %.1f KB, %zu bytes per snapshot, %zu presses logged\n", travel_memory(&t) / 1024.0,
+		sizeof(TravelSnapshot), t.log_count);
+	printf("Seeks:        %" PRIu64 " random, mean %.2f ms, max %.2f ms, %" PRIu64 " outside the window\n", seeks,
+		seeks ? total / seeks * 1e3 : 0, worst * 1e3, missed);
+	printf("Checked:      %d seeks against copies of the run, %u differ\n", CHECKS, differ);
+
+	travel_free(&t);
+	return differ || missed;
+}
@@ -0,0 +1,126 @@
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ring.h"
+
+#define RING_MAGIC 0x474E4952454B414Eull	/* "NAKERING" */
+
+/* Slots start on a cache line after the header */
+static size_t data_offset(void) {
+	return (sizeof(RingHeader) + 63) / 64 * 64;
+}
+
+/* Map a shared memory object, the descriptor is closed either way */
+static int map(Ring *r, int fd, size_t size) {
+	void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	close(fd);
+	if (p == MAP_FAILED) {
+		return -1;
+	}
+	r->h = p;
+	r->data = (uint8_t *)p + data_offset();
+	r->map_size = size;
+	return 0;
+}
+
+int ring_create(Ring *r, const char *name, uint64_t slots, uint64_t slot_size) {
+	slot_size = (slot_size + 63) / 64 * 64;
+	size_t size = data_offset() + slots * slot_size;
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+	if (fd < 0) {
+		return -1;
+	}
+	if (ftruncate(fd, size)) {
+		close(fd);
+		shm_unlink(name);
+		return -1;
+	}
+	if (map(r, fd, size)) {
+		shm_unlink(name);
+		return -1;
+	}
+
+	r->h->slots = slots;
+	r->h->slot_size = slot_size;
+	atomic_store(&r->h->written, 0);
+	atomic_store(&r->h->read, 0);
+	atomic_store(&r->h->closed, 0);
+	atomic_store_explicit(&r->h->magic, RING_MAGIC, memory_order_release);
+	return 0;
+}
+
+int ring_open(Ring *r, const char *name) {
+	int fd = shm_open(name, O_RDWR, 0);
+	off_t size;
+
+	if (fd < 0) {
+		return -1;
+	}
+	if ((size = lseek(fd, 0, SEEK_END)) < (off_t)data_offset()) {
+		close(fd);
+		return -1;
+	}
+	if (map(r, fd, size)) {
+		return -1;
+	}
+
+	/* The creator fills the header in after sizing the object */
+	while (atomic_load_explicit(&r->h->magic, memory_order_acquire) != RING_MAGIC) {
+		sched_yield();
+	}
+	return 0;
+}
+
+void ring_close(Ring *r) {
+	if (r->h) {
+		munmap(r->h, r->map_size);
+	}
+	memset(r, 0, sizeof(*r));
+}
+
+void ring_unlink(const char *name) {
+	shm_unlink(name);
+}
+
+void *ring_acquire(Ring *r) {
+	uint64_t written = atomic_load_explicit(&r->h->written, memory_order_relaxed);
+
+	while (written - atomic_load_explicit(&r->h->read, memory_order_acquire) >= r->h->slots) {
+		sched_yield();
+	}
+	return r->data + written % r->h->slots * r->h->slot_size;
+}
+
+void ring_publish(Ring *r) {
+	atomic_fetch_add_explicit(&r->h->written, 1, memory_order_release);
+}
+
+void ring_finish(Ring *r) {
+	atomic_store_explicit(&r->h->closed, 1, memory_order_release);
+}
+
+const void *ring_next(Ring *r) {
+	uint64_t read = atomic_load_explicit(&r->h->read, memory_order_relaxed);
+
+	while (atomic_load_explicit(&r->h->written, memory_order_acquire) == read) {
+		/* Check for the end before the last look, a slot may come with it */
+		if (atomic_load_explicit(&r->h->closed, memory_order_acquire)) {
+			if (atomic_load_explicit(&r->h->written, memory_order_acquire) == read) {
+				return NULL;
+			}
+			break;
+		}
+		sched_yield();
+	}
+	return r->data + read % r->h->slots * r->h->slot_size;
+}
+
+void ring_release(Ring *r) {
+	atomic_fetch_add_explicit(&r->h->read, 1, memory_order_release);
+}
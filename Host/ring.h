@@ -0,0 +1,43 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Single producer, single consumer ring of fixed size slots in POSIX shared
+ * memory, so a process can hand frames to another one without copying. The
+ * producer writes straight into a slot and publishes it, the consumer reads
+ * it in place and releases it. The producer waits while the ring is full.
+ */
+typedef struct {
+	_Atomic uint64_t magic;					/* Set last by the creator */
+	uint64_t slots;
+	uint64_t slot_size;
+	_Alignas(64) _Atomic uint64_t written;	/* Slots published so far */
+	_Alignas(64) _Atomic uint64_t read;		/* Slots released so far */
+	_Alignas(64) _Atomic uint32_t closed;	/* No more slots are coming */
+} RingHeader;
+
+typedef struct {
+	RingHeader *h;
+	uint8_t *data;
+	size_t map_size;
+} Ring;
+
+/* Create (producer) or attach to (consumer) the ring of a shm_open() name */
+int ring_create(Ring *r, const char *name, uint64_t slots, uint64_t slot_size);
+int ring_open(Ring *r, const char *name);
+void ring_close(Ring *r);
+void ring_unlink(const char *name);
+
+/* Producer: next free slot, waiting for one, then publish it */
+void *ring_acquire(Ring *r);
+void ring_publish(Ring *r);
+void ring_finish(Ring *r);
+
+/* Consumer: oldest published slot, waiting for one, NULL once finished */
+const void *ring_next(Ring *r);
+void ring_release(Ring *r);
+
+#endif /* RING_H */
@@ -0,0 +1,74 @@
+/*
+ * Engine throughput for one board geometry. Built once per geometry with
+ * ROWS, COLS, SNAKE_MAX_LENGTH and SNAKE_WALLS defined, the same sources the
+ * firmware uses for the 16x8 matrix.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "play.h"
+#include "snake.h"
+#include "tools.h"
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n TICKS   game ticks to run (default 20000000)\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	uint64_t ticks = 20000000, games = 0, lengths = 0, checked = 0;
+	uint32_t r = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+			case 'n': ticks = strtoull(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+
+	static Snake s;
+	const char *why;
+	struct timespec t0, t1;
+
+	init_snake(&s, 1);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint64_t t = 0; t < ticks; t++) {
+		steer_snake(&s, greedy_steer(&s, xorshift(&r)));
+		update_snake(&s);
+
+		/* Spot checks keep the run fast on large boards */
+		if (t % 1024 == 0 || s.state != PLAYING) {
+			checked++;
+			if ((why = check_snake(&s))) {
+				printf("tick %" PRIu64 ": %s\n", t, why);
+				return 1;
+			}
+		}
+		if (s.state != PLAYING) {
+			games++;
+			lengths += s.length;
+			init_snake(&s, r);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double elapsed = seconds(&t0, &t1);
+
+	printf("Board:        %dx%d, %s, game won at length %d\n", COLS, ROWS, SNAKE_WALLS ? "walls" : "wrapping",
+		SNAKE_MAX_LENGTH);
+	printf("Types:        %zu byte cells, %zu byte lengths, %d bitboard words, %zu byte Snake\n",
+		sizeof(Cell), sizeof(Length), BOARD_WORDS, sizeof(Snake));
+	printf("Throughput:   %.1f M ticks/s with steering, %" PRIu64 " states checked\n", ticks / elapsed * 1e-6, checked);
+	if (games) {
+		printf("Games:        %" PRIu64 " ended, final length %.1f mean\n", games, (double)lengths / games);
+	}
+	return 0;
+}
@@ -0,0 +1,532 @@
+#include <string.h>
+
+#include "display.h"
+#include "sim.h"
+
+/* Board that the matrix pin functions of the current thread act on */
+static _Thread_local Sim *sim_current;
+
+void sim_default_config(SimConfig *cfg) {
+	memset(cfg, 0, sizeof(*cfg));
+
+	/* CLOCK_SETUP 0 in system_MK60DZ10.c, core and bus at 41.94 MHz */
+	cfg->core_hz = 41943040u;
+	cfg->bus_div = 1;
+
+	/* Reload value from PIT_Init(), timer periods from main() */
+	cfg->ldval = WHEEL_LDVAL;
+	cfg->period[EVENT_TICK] = 1000;
+	cfg->period[EVENT_REFRESH] = 1;
+	cfg->governed = 1;
+
+	/* Seed passed to init_snake() by main() */
+	cfg->seed = 1;
+
+	cfg->loop_cycles = 10;
+	cfg->outer_cycles = 14;
+	cfg->isr_cycles = 24;
+	cfg->post_cycles = 30;
+	cfg->expire_cycles = 16;
+	cfg->take_cycles = 20;
+	cfg->row_cycles = 110;
+	cfg->column_cycles = 30;
+	cfg->clear_cycles = 180;
+	cfg->update_cycles = 220;
+	cfg->steer_cycles = 150;
+
+	cfg->run_ua = 20000;
+	cfg->wait_ua = 9000;
+	cfg->stop_ua = 300;
+}
+
+/* Bring the light counters of one LED up to the current time */
+static void sim_account(Sim *s, unsigned row, unsigned col) {
+	SimPixel *p = &s->pixel[row][col];
+	uint64_t dt = s->now - p->since;
+
+	if (s->column == col && (s->rows & (1u << row))) {
+		p->lit += dt;
+		if (!p->count) {
+			p->ghost += dt;
+		}
+	}
+	if (p->count) {
+		p->occupied += dt;
+	}
+	p->since = s->now;
+}
+
+/* Change the matrix outputs */
+static void sim_drive(Sim *s, unsigned rows, unsigned column) {
+	if (rows == s->rows && column == s->column) {
+		return;
+	}
+
+	for (unsigned r = 0; r < ROWS; r++) {
+		if (s->rows & (1u << r)) {
+			sim_account(s, r, s->column);
+		}
+		if (rows & (1u << r)) {
+			sim_account(s, r, column);
+		}
+	}
+
+	for (unsigned r = 0; r < ROWS; r++) {
+		int was_on = (s->rows & (1u << r)) && s->column == column;
+		SimPixel *p = &s->pixel[r][column];
+
+		if (!(rows & (1u << r)) || was_on) {
+			continue;
+		}
+
+		/* The LED has just been switched on */
+		if (s->probe == 2 && s->probe_cell[0] == (int)r && s->probe_cell[1] == (int)column) {
+			uint64_t latency = s->now - s->probe_at;
+
+			s->latency_sum += latency;
+			s->latency_count++;
+			if (latency > s->latency_max) {
+				s->latency_max = latency;
+			}
+			s->probe = 0;
+		}
+		/*
+		 * Where other columns came or went, the LED moved in the frame and
+		 * this gap is longer once; that is kept apart from the steady rate.
+		 */
+		if (p->count && p->refreshes && p->last_on >= p->occupied_since) {
+			uint64_t gap = s->now - p->last_on;
+			if (p->layout != s->layout) {
+				if (gap > s->layout_gap) {
+					s->layout_gap = gap;
+				}
+			} else if (gap > p->max_gap) {
+				p->max_gap = gap;
+			}
+		}
+		p->last_on = s->now;
+		p->layout = s->layout;
+		p->refreshes++;
+	}
+
+	s->address_edges += __builtin_popcount(s->column ^ column);
+	s->rows = rows;
+	s->column = column;
+}
+
+/* Update which cells the game wants lit, none while the matrix is blanked */
+static void sim_occupy(Sim *s) {
+	for (unsigned c = 0; c < COLS; c++) {
+		unsigned bits = s->blanked ? 0 : snake_column(&s->snake, c);
+
+		for (unsigned r = 0; r < ROWS; r++) {
+			SimPixel *p = &s->pixel[r][c];
+			uint8_t count = (bits >> r) & 1;
+
+			if (p->count == count) {
+				continue;
+			}
+			sim_account(s, r, c);
+			if (!p->count) {
+				p->occupied_since = s->now;
+			}
+			p->count = count;
+		}
+	}
+}
+
+/* Latch the LEDs that were on long enough during the frame to be seen */
+static void sim_frame(Sim *s) {
+	uint64_t visible = (s->now - s->frame_start) / 100;
+
+	for (unsigned c = 0; c < COLS; c++) {
+		uint8_t bits = 0;
+
+		for (unsigned r = 0; r < ROWS; r++) {
+			SimPixel *p = &s->pixel[r][c];
+
+			sim_account(s, r, c);
+			if (p->lit - p->frame_lit > visible) {
+				bits |= 1u << r;
+			}
+			p->frame_lit = p->lit;
+		}
+		s->frame[c] = bits;
+	}
+	s->frame_start = s->now;
+}
+
+/* Raise the interrupt flags that are due */
+static void sim_latch(Sim *s) {
+	while (s->pit_next <= s->now) {
+		if (s->pending[SIM_PIT0]) {
+			s->overruns++;
+		}
+		s->pending[SIM_PIT0] = 1;
+		s->pit_next += s->pit_period;
+	}
+
+	if (s->button_count && s->button_at[s->button_head] <= s->now) {
+		s->pending[SIM_PORTE] = 1;
+	}
+}
+
+/* Time of the next interrupt request */
+static uint64_t sim_next_event(const Sim *s) {
+	uint64_t next = s->pit_next;
+
+	if (s->button_count && s->button_at[s->button_head] > s->now && s->button_at[s->button_head] < next) {
+		next = s->button_at[s->button_head];
+	}
+	return next;
+}
+
+static void sim_handler(Sim *s, int irq);
+
+/* Highest priority pending interrupt that may preempt the running code, -1 if none */
+static int sim_preempting(Sim *s) {
+	sim_latch(s);
+	for (int irq = 0; irq < s->active; irq++) {
+		if (s->pending[irq]) {
+			return irq;
+		}
+	}
+	return -1;
+}
+
+/* Take an interrupt */
+static void sim_enter(Sim *s, int irq) {
+	int prev = s->active;
+
+	s->pending[irq] = 0;
+	s->active = irq;
+	s->runs[irq]++;
+	sim_handler(s, irq);
+	s->active = prev;
+}
+
+/* Enter every pending handler that may preempt the running code */
+static void sim_dispatch(Sim *s) {
+	int irq;
+
+	while ((irq = sim_preempting(s)) >= 0) {
+		sim_enter(s, irq);
+	}
+}
+
+/* Execute a number of cycles of the running code, servicing preemptions */
+static void sim_consume(Sim *s, uint64_t cycles) {
+	while (cycles) {
+		uint64_t step = sim_next_event(s) - s->now;
+
+		if (step > cycles) {
+			step = cycles;
+		}
+		s->now += step;
+		s->busy[s->active] += step;
+		cycles -= step;
+		sim_dispatch(s);
+	}
+}
+
+/* Bodies of PORTE_IRQHandler() and PIT0_IRQHandler() */
+static void sim_handler(Sim *s, int irq) {
+	sim_consume(s, s->cfg.isr_cycles);
+
+	switch (irq) {
+		case SIM_PORTE:
+			while (s->button_count && s->button_at[s->button_head] <= s->now) {
+				if (!s->probe) {
+					s->probe = 1;
+					s->probe_at = s->button_at[s->button_head];
+				}
+				press_put(&s->presses, s->button[s->button_head]);
+				s->button_head = (s->button_head + 1) % SIM_BUTTONS;
+				s->button_count--;
+			}
+			sim_consume(s, s->cfg.steer_cycles);
+			break;
+		case SIM_PIT0: {
+			uint32_t expired = s->wheel.expired;
+
+			sim_consume(s, s->cfg.post_cycles);
+			wheel_tick(&s->wheel, &s->events);
+			sim_consume(s, (uint64_t)(s->wheel.expired - expired) * s->cfg.expire_cycles);
+			break;
+		}
+	}
+}
+
+/* govern() of the main loop */
+static void sim_govern(Sim *s) {
+	int moving = s->snake.state == PLAYING && s->snake.dir != STOP;
+	int lit = !power_dark(&s->power) && !frame_blank(&s->published);
+	int running = s->governor.period != 0;
+
+	if (!governor_update(&s->governor, moving, lit)) {
+		return;
+	}
+	if (!s->governor.period) {
+		timer_cancel(&s->wheel, EVENT_REFRESH);
+	} else if (!running) {
+		timer_start(&s->wheel, EVENT_REFRESH, 1, s->governor.period);
+	} else {
+		timer_period(&s->wheel, EVENT_REFRESH, s->governor.period);
+	}
+}
+
+/* game_tick() and refresh() of the main loop, preempted by the handlers */
+static void sim_event(Sim *s, Event e) {
+	uint64_t busy = s->busy[SIM_THREAD];
+
+	sim_consume(s, s->cfg.take_cycles);
+	switch (e) {
+		case EVENT_TICK: {
+			Direction dir;
+			int pressed = 0;
+
+			sim_consume(s, s->cfg.update_cycles);
+			while (press_take(&s->presses, &dir)) {
+				steer_snake(&s->snake, dir);
+				pressed = 1;
+			}
+			update_snake(&s->snake);
+			frame_publish(&s->published, &s->snake);
+			power_tick(&s->power, !pressed && s->snake.state == PLAYING && s->snake.dir == STOP);
+			sim_occupy(s);
+			if (s->probe == 1) {
+				s->probe = 2;
+				s->probe_cell[0] = CELL_ROW(snake_segment(&s->snake, 0));
+				s->probe_cell[1] = CELL_COL(snake_segment(&s->snake, 0));
+			}
+			break;
+		}
+		case EVENT_REFRESH: {
+			uint32_t start = s->wheel.now;
+
+			/* The game tick runs in this thread, so the refresh reads what it published */
+			if (s->published.used != s->scanned) {
+				s->scanned = s->published.used;
+				s->layout++;
+			}
+			display_frame(&s->published);
+			governor_refresh(&s->governor, s->wheel.now - start);
+			sim_frame(s);
+			s->frames++;
+			break;
+		}
+		default:
+			break;
+	}
+	if (s->cfg.governed) {
+		sim_govern(s);
+	}
+	s->event_busy[e] += s->busy[SIM_THREAD] - busy;
+	s->event_runs[e]++;
+}
+
+void sim_init(Sim *s, const SimConfig *cfg) {
+	memset(s, 0, sizeof(*s));
+	s->cfg = *cfg;
+	s->active = SIM_THREAD;
+
+	s->pit_period = (uint64_t)(cfg->ldval + 1) * cfg->bus_div;
+	s->pit_next = s->pit_period;
+
+	wheel_init(&s->wheel);
+	for (int e = 0; e < EVENTS; e++) {
+		s->event_period[e] = cfg->period[e] * s->pit_period;
+		timer_start(&s->wheel, (Event)e, cfg->period[e], cfg->period[e]);
+	}
+
+	power_init(&s->power);
+	governor_init(&s->governor, cfg->period[EVENT_REFRESH]);
+	init_snake(&s->snake, cfg->seed);
+	frame_publish(&s->published, &s->snake);
+	sim_occupy(s);
+}
+
+int sim_press(Sim *s, uint64_t at, Direction dir) {
+	if (s->button_count == SIM_BUTTONS) {
+		return -1;
+	}
+
+	unsigned i = (s->button_head + s->button_count) % SIM_BUTTONS;
+	s->button[i] = dir;
+	s->button_at[i] = at;
+	s->button_count++;
+	return 0;
+}
+
+/* stop() of main(), the PIT stands still until a button wakes the board or the run ends */
+static void sim_stop(Sim *s, uint64_t end) {
+	uint64_t wake = s->button_count && s->button_at[s->button_head] < end ? s->button_at[s->button_head] : end;
+
+	if (!s->blanked) {
+		s->blanked = 1;
+		s->stops++;
+		sim_occupy(s);
+	}
+	s->stopped += wake - s->now;
+	s->pit_next += wake - s->now;
+	s->now = wake;
+
+	/* A run that ends first leaves the board stopped for the next one */
+	if (wake < end || (s->button_count && s->button_at[s->button_head] <= wake)) {
+		s->blanked = 0;
+		sim_occupy(s);
+	}
+}
+
+void sim_run(Sim *s, uint64_t cycles) {
+	Sim *prev = sim_current;
+	uint64_t end = s->now + cycles;
+
+	/* Back-to-back handlers and events may starve main(), so check the end time between them */
+	sim_current = s;
+	while (s->now < end) {
+		int irq = sim_preempting(s);
+		Event e;
+
+		if (irq >= 0) {
+			sim_enter(s, irq);
+			continue;
+		}
+		if ((e = event_take(&s->events)) != EVENTS) {
+			sim_event(s, e);
+			continue;
+		}
+
+		/* Nothing to do, main() sleeps until the next interrupt */
+		if (power_mode(&s->power, s->events.pending, s->presses.in - s->presses.out) == POWER_STOP) {
+			sim_stop(s, end);
+			continue;
+		}
+		uint64_t next = sim_next_event(s);
+		if (next > end) {
+			next = end;
+		}
+		s->asleep += next - s->now;
+		s->now = next;
+	}
+	sim_current = prev;
+}
+
+void sim_flush(Sim *s) {
+	for (unsigned r = 0; r < ROWS; r++) {
+		for (unsigned c = 0; c < COLS; c++) {
+			sim_account(s, r, c);
+		}
+	}
+}
+
+double sim_duty(const Sim *s, int row, int col) {
+	const SimPixel *p = &s->pixel[row][col];
+
+	if (!p->occupied) {
+		return -1.0;
+	}
+	return (double)(p->lit - p->ghost) / p->occupied;
+}
+
+void sim_report(Sim *s, SimReport *r) {
+	double hz = s->cfg.core_hz;
+	uint64_t lit = 0, ghost = 0, worst_gap = 0, busy = 0;
+
+	sim_flush(s);
+	memset(r, 0, sizeof(*r));
+	r->seconds = s->now / hz;
+	r->worst_cell[0] = r->worst_cell[1] = -1;
+	r->min_duty = 1.0;
+
+	for (int row = 0; row < ROWS; row++) {
+		for (int col = 0; col < COLS; col++) {
+			const SimPixel *p = &s->pixel[row][col];
+			double duty = sim_duty(s, row, col);
+
+			lit += p->lit;
+			ghost += p->ghost;
+			if (duty < 0) {
+				continue;
+			}
+
+			if (duty < r->min_duty) r->min_duty = duty;
+			if (duty > r->max_duty) r->max_duty = duty;
+			r->mean_duty += duty;
+			r->cells++;
+
+			if (p->max_gap > worst_gap) {
+				worst_gap = p->max_gap;
+				r->worst_cell[0] = row;
+				r->worst_cell[1] = col;
+			}
+		}
+	}
+
+	for (int irq = 0; irq < SIM_THREAD; irq++) {
+		r->load[irq] = s->now ? (double)s->busy[irq] / s->now : 0.0;
+		busy += s->busy[irq];
+	}
+	r->isr_load = s->now ? (double)busy / s->now : 0.0;
+	for (int e = 0; e < EVENTS; e++) {
+		r->event_load[e] = s->now ? (double)s->event_busy[e] / s->now : 0.0;
+	}
+	r->cpu_load = s->now ? 1.0 - (double)(s->asleep + s->stopped) / s->now : 0.0;
+	r->stopped = s->now ? (double)s->stopped / s->now : 0.0;
+	if (s->now) {
+		double awake = s->now - s->asleep - s->stopped;
+
+		r->current = (awake * s->cfg.run_ua + (double)s->asleep * s->cfg.wait_ua +
+			(double)s->stopped * s->cfg.stop_ua) / s->now / 1000;
+	}
+
+	if (r->cells) {
+		r->mean_duty /= r->cells;
+		r->nonuniformity = r->max_duty > 0 ? (r->max_duty - r->min_duty) / r->max_duty : 0.0;
+	} else {
+		r->min_duty = 0.0;
+	}
+	/* The frame rate counts the time the matrix was on */
+	r->frame_rate = s->now > s->stopped ? s->frames / ((s->now - s->stopped) / hz) : 0.0;
+	r->pixel_rate = worst_gap ? hz / worst_gap : r->frame_rate;
+	r->layout_rate = s->layout_gap ? hz / s->layout_gap : r->pixel_rate;
+	r->ghost = lit ? (double)ghost / lit : 0.0;
+	if (s->latency_count) {
+		r->latency = s->latency_sum / hz / s->latency_count;
+		r->max_latency = s->latency_max / hz;
+	}
+}
+
+/* Matrix pin functions called by display_frame() */
+
+void delay(int t1, int t2) {
+	Sim *s = sim_current;
+
+	/* The dwell of a full matrix column is replaced, a share of a frame scales with it */
+	if (s->cfg.dwell) {
+		t1 = (uint64_t)t1 * s->cfg.dwell / DISPLAY_DWELL / t2;
+	}
+	sim_consume(s, (uint64_t)t1 * t2 * s->cfg.loop_cycles + (uint64_t)t1 * s->cfg.outer_cycles);
+}
+
+void column_select(unsigned int col_num) {
+	Sim *s = sim_current;
+
+	sim_consume(s, s->cfg.column_cycles);
+	sim_drive(s, s->rows, col_num);
+	s->selects++;
+}
+
+void row_write(unsigned int rows) {
+	Sim *s = sim_current;
+
+	sim_consume(s, s->cfg.row_cycles);
+	sim_drive(s, rows, s->column);
+}
+
+void matrix_clear(void) {
+	Sim *s = sim_current;
+
+	sim_consume(s, s->cfg.clear_cycles);
+	sim_drive(s, 0, 0);
+}
@@ -0,0 +1,158 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+#include "events.h"
+#include "frame.h"
+#include "governor.h"
+#include "power.h"
+#include "presses.h"
+#include "snake.h"
+#include "wheel.h"
+
+/* Interrupt sources, in NVIC priority order as set up by SystemConfig() and PIT_Init() */
+enum {
+	SIM_PORTE,		/* Buttons, priority 1 */
+	SIM_PIT0,		/* Timer wheel, priority 2 */
+	SIM_THREAD		/* main(), the event loop */
+};
+
+#define SIM_BUTTONS 16
+
+/* Clock, timer and cycle cost model of the board */
+typedef struct {
+	uint32_t core_hz;		/* Core clock */
+	uint32_t bus_div;		/* Core clock / bus clock, the PIT counts bus clocks */
+	uint32_t ldval;			/* PIT0 reload value, one tick of the timer wheel */
+	uint32_t period[EVENTS];/* Wheel ticks between game ticks and between refreshes */
+	uint32_t governed;		/* The governor sets the refresh period from the first refresh on */
+	uint32_t dwell;			/* delay() inner iterations per column of a full matrix, 0 keeps the firmware's own */
+	uint32_t seed;			/* Food placement seed */
+
+	/* Cycle estimates for the -O0 Debug build */
+	uint32_t loop_cycles;	/* One inner iteration of delay() */
+	uint32_t outer_cycles;	/* One outer iteration of delay() */
+	uint32_t isr_cycles;	/* Exception entry and exit */
+	uint32_t post_cycles;	/* PIT handler body, clearing the flag and turning the wheel */
+	uint32_t expire_cycles;	/* Each timer the wheel expires, posting its event */
+	uint32_t take_cycles;	/* Main loop taking an event */
+	uint32_t row_cycles;	/* row_write() */
+	uint32_t column_cycles;	/* column_select() */
+	uint32_t clear_cycles;	/* matrix_clear() */
+	uint32_t update_cycles;	/* update_snake() */
+	uint32_t steer_cycles;	/* PORTE_IRQHandler() */
+
+	/* Supply current of the MCU in uA, LEDs excluded, rough data sheet figures */
+	uint32_t run_ua;		/* Running */
+	uint32_t wait_ua;		/* Asleep in WFI */
+	uint32_t stop_ua;		/* Stopped in VLPS */
+} SimConfig;
+
+/* Light statistics of one LED */
+typedef struct {
+	uint64_t lit;			/* Cycles the LED was driven */
+	uint64_t occupied;		/* Cycles the cell held the snake or the food */
+	uint64_t ghost;			/* Cycles the LED was driven while the cell was empty */
+	uint64_t since;			/* Time the counters above were last brought up to date */
+	uint64_t occupied_since;/* Start of the current occupied interval */
+	uint64_t last_on;		/* Last time the LED was switched on */
+	uint64_t max_gap;		/* Longest time between two refreshes while occupied */
+	uint64_t frame_lit;		/* Value of lit when the current frame started */
+	uint32_t refreshes;		/* Number of times the LED was switched on */
+	uint32_t layout;		/* Layout of the frame it was last switched on in */
+	uint8_t count;			/* Whether the game wants the LED lit */
+} SimPixel;
+
+/* One simulated board */
+typedef struct {
+	SimConfig cfg;
+	Snake snake;
+
+	uint64_t now;					/* Core cycles since reset */
+	uint64_t pit_period;			/* PIT0 period in core cycles */
+	uint64_t pit_next;				/* Next PIT0 expiry */
+	int pending[SIM_THREAD];		/* Interrupt flags waiting for service */
+	int active;						/* Source of the code running now */
+
+	uint64_t busy[SIM_THREAD + 1];	/* Cycles spent by each source, excluding preemption and sleep */
+	uint64_t runs[SIM_THREAD];		/* Handler invocations */
+	uint64_t overruns;				/* PIT expiries lost because the flag was still set */
+	uint64_t asleep;				/* Cycles main() slept in WFI */
+	uint64_t stopped;				/* Cycles the board stood in VLPS, the PIT with it */
+	uint64_t stops;
+	Power power;					/* Kept by the game tick, decides how deep main() sleeps */
+	int blanked;					/* #EN is high, the matrix is dark */
+
+	Events events;					/* Work posted by the timers */
+	Wheel wheel;					/* Timers of the game tick and the refresh, their misses */
+	uint64_t event_period[EVENTS];	/* Timer periods in core cycles as configured */
+	Governor governor;				/* Refresh period for the picture */
+	uint64_t event_busy[EVENTS];	/* Cycles main() spent on each event, excluding preemption */
+	uint64_t event_runs[EVENTS];
+	uint64_t frames;				/* Completed display_snake() calls */
+
+	Direction button[SIM_BUTTONS];	/* Queued button presses */
+	uint64_t button_at[SIM_BUTTONS];
+	unsigned button_head, button_count;
+	PressQueue presses;				/* Presses taken by PORTE, applied by the next game tick */
+
+	Frame published;				/* Image the game tick publishes for the refresh */
+	unsigned rows;					/* Row driver outputs, bit per row */
+	unsigned column;				/* 74HC154 address */
+	uint64_t address_edges;			/* Changes of the address lines A0-A3 */
+	uint64_t selects;				/* column_select() calls */
+	SimPixel pixel[ROWS][COLS];
+	uint64_t frame_start;			/* Time the current frame started */
+	uint8_t frame[COLS];			/* LEDs visible in the last completed frame, bit per row */
+	uint16_t scanned;				/* Columns the last refresh visited */
+	uint32_t layout;				/* Changes of the columns visited, which move the others in the frame */
+	uint64_t layout_gap;			/* Longest time between two refreshes across such a change */
+
+	/* Press-to-light latency probe, follows one button press at a time */
+	int probe;						/* 0 idle, 1 waiting for the game tick, 2 waiting for the LED */
+	uint64_t probe_at;				/* Time of the press */
+	int probe_cell[2];				/* Head cell [row, col] the press lead to */
+	uint64_t latency_sum, latency_max, latency_count;
+} Sim;
+
+/* Summary of a finished run */
+typedef struct {
+	double seconds;
+	double frame_rate;				/* Completed frames per second */
+	double pixel_rate;				/* Refresh rate of the slowest occupied pixel */
+	double layout_rate;				/* Refresh rate over the longest gap across a change of the columns lit */
+	int worst_cell[2];				/* That pixel [row, col], -1 if nothing was lit */
+	double load[SIM_THREAD];		/* Fraction of time in each handler */
+	double isr_load;				/* Fraction of time in any handler */
+	double event_load[EVENTS];		/* Fraction of time main() spent on each event */
+	double cpu_load;				/* Fraction of time the core was awake */
+	double stopped;					/* Fraction of time the board was stopped */
+	double current;					/* Mean supply current of the MCU in mA */
+	int cells;						/* Cells the snake occupied during the run */
+	double min_duty, mean_duty, max_duty;
+	double nonuniformity;			/* (max - min) / max duty cycle */
+	double ghost;					/* Fraction of lit time on empty cells */
+	double latency;					/* Mean press-to-light latency in seconds, 0 if no press */
+	double max_latency;
+} SimReport;
+
+void sim_default_config(SimConfig *cfg);
+void sim_init(Sim *s, const SimConfig *cfg);
+
+/* Queue a button press at an absolute time, presses must come in time order */
+int sim_press(Sim *s, uint64_t at, Direction dir);
+
+/* Run the board for a number of core cycles */
+void sim_run(Sim *s, uint64_t cycles);
+
+/* Close all open light intervals so the pixel statistics cover s->now */
+void sim_flush(Sim *s);
+
+/* Flush and summarize the statistics collected since sim_init() */
+void sim_report(Sim *s, SimReport *r);
+
+/* Duty cycle of one pixel while it was occupied, -1 if it never was */
+double sim_duty(const Sim *s, int row, int col);
+
+#endif /* SIM_H */
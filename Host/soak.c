@@ -0,0 +1,224 @@
+/* Monte Carlo soak test of the game engine with randomized button schedules */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "pool.h"
+#include "snake.h"
+#include "tools.h"
+
+#define MAX_FAILURES 16
+
+/* Results of one worker, merged when all games are done */
+typedef struct {
+	_Alignas(64) uint64_t games, ticks, presses;
+	uint64_t ended[3];					/* Games per final GameState */
+	uint64_t length[CELLS + 1];			/* Games per final length */
+	uint64_t failures;
+	uint64_t failed_seed[MAX_FAILURES];
+	const char *failed_why[MAX_FAILURES];
+} Stats;
+
+typedef struct {
+	uint64_t base;
+	uint32_t max_ticks;
+	Stats *stats;
+} Soak;
+
+/* Direction that closes the shorter way to the food along one axis */
+static Direction toward_food(const Snake *s, uint64_t r) {
+	unsigned head = snake_segment(s, 0);
+	unsigned dr = (CELL_ROW(s->food) + ROWS - CELL_ROW(head)) % ROWS;
+	unsigned dc = (CELL_COL(s->food) + COLS - CELL_COL(head)) % COLS;
+
+	if (dr && (!dc || (r & 1))) {
+		return dr < ROWS / 2 ? LEFT : RIGHT;
+	}
+	return dc < COLS / 2 ? DOWN : UP;
+}
+
+/*
+ * Play one game. Everything random derives from the seed, so a failing game
+ * replays exactly with -r. Between two game ticks up to three buttons are
+ * pressed, which is where a fast double press can race the tick.
+ */
+static const char *play(uint64_t seed, uint32_t max_ticks, Stats *st, int verbose) {
+	uint64_t rng = seed;
+	Snake s;
+	const char *why;
+
+	init_snake(&s, (uint32_t)splitmix64(&rng));
+	if ((why = check_snake(&s))) {
+		return why;
+	}
+
+	uint32_t tick;
+	for (tick = 0; tick < max_ticks && s.state == PLAYING; tick++) {
+		uint64_t r = splitmix64(&rng);
+		unsigned roll = r % 100, presses = roll < 50 ? 0 : roll < 80 ? 1 : roll < 95 ? 2 : 3;
+
+		for (unsigned i = 0; i < presses; i++) {
+			uint64_t p = splitmix64(&rng);
+			Direction dir;
+
+			if (p % 64 == 0) {
+				dir = STOP;
+			} else if (p & 2) {
+				dir = toward_food(&s, p >> 8);
+			} else {
+				dir = (Direction)(RIGHT + (p >> 8) % 4);
+			}
+
+			steer_snake(&s, dir);
+			st->presses++;
+			if (verbose) {
+				printf("tick %" PRIu32 ": press %d -> dir %d\n", tick, dir, s.dir);
+			}
+			if ((why = check_snake(&s))) {
+				return why;
+			}
+		}
+
+		update_snake(&s);
+		if (verbose) {
+			unsigned head = snake_segment(&s, 0);
+			printf("tick %" PRIu32 ": head (%u,%u) length %u food (%u,%u) state %d\n", tick,
+				CELL_ROW(head), CELL_COL(head), s.length, CELL_ROW(s.food), CELL_COL(s.food), s.state);
+		}
+		if ((why = check_snake(&s))) {
+			return why;
+		}
+	}
+
+	st->games++;
+	st->ticks += tick;
+	st->ended[s.state]++;
+	st->length[s.length]++;
+	return NULL;
+}
+
+static void soak_chunk(void *arg, int worker, uint64_t begin, uint64_t end) {
+	Soak *soak = arg;
+	Stats *st = &soak->stats[worker];
+
+	for (uint64_t i = begin; i < end; i++) {
+		const char *why = play(soak->base + i, soak->max_ticks, st, 0);
+
+		if (why) {
+			if (st->failures < MAX_FAILURES) {
+				st->failed_seed[st->failures] = soak->base + i;
+				st->failed_why[st->failures] = why;
+			}
+			st->failures++;
+		}
+	}
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n GAMES   number of games (default 1000000)\n"
+		"  -b SEED    seed of the first game (default 1)\n"
+		"  -t TICKS   tick limit per game (default 5000)\n"
+		"  -j N       worker threads (default all CPUs)\n"
+		"  -r SEED    replay one game single-threaded and trace it\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	uint64_t games = 1000000, replay = 0;
+	int workers = pool_cpus(), replaying = 0, opt;
+	Soak soak = { .base = 1, .max_ticks = 5000 };
+
+	while ((opt = getopt(argc, argv, "n:b:t:j:r:")) != -1) {
+		switch (opt) {
+			case 'n': games = strtoull(optarg, NULL, 0); break;
+			case 'b': soak.base = strtoull(optarg, NULL, 0); break;
+			case 't': soak.max_ticks = strtoul(optarg, NULL, 0); break;
+			case 'j': workers = atoi(optarg); break;
+			case 'r': replay = strtoull(optarg, NULL, 0); replaying = 1; break;
+			default: usage(argv[0]);
+		}
+	}
+	if (workers < 1 || games > UINT32_MAX) {
+		usage(argv[0]);
+	}
+
+	if (replaying) {
+		static Stats st;
+		const char *why = play(replay, soak.max_ticks, &st, 1);
+
+		printf("seed %" PRIu64 ": %s\n", replay, why ? why : "ok");
+		return why ? 1 : 0;
+	}
+
+	soak.stats = aligned_alloc(64, sizeof(Stats) * workers);
+	memset(soak.stats, 0, sizeof(Stats) * workers);
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	pool_for(games, workers, 256, soak_chunk, &soak);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double elapsed = seconds(&t0, &t1);
+
+	/* Merge the per-worker results */
+	Stats total;
+	memset(&total, 0, sizeof(total));
+	for (int w = 0; w < workers; w++) {
+		const Stats *st = &soak.stats[w];
+
+		total.games += st->games;
+		total.ticks += st->ticks;
+		total.presses += st->presses;
+		for (int i = 0; i < 3; i++) {
+			total.ended[i] += st->ended[i];
+		}
+		for (int i = 0; i <= CELLS; i++) {
+			total.length[i] += st->length[i];
+		}
+		for (uint64_t i = 0; i < st->failures && i < MAX_FAILURES; i++) {
+			if (total.failures + i < MAX_FAILURES) {
+				total.failed_seed[total.failures + i] = st->failed_seed[i];
+				total.failed_why[total.failures + i] = st->failed_why[i];
+			}
+		}
+		total.failures += st->failures;
+	}
+
+	printf("Games:        %" PRIu64 " on %d threads in %.2f s\n", games, workers, elapsed);
+	printf("Throughput:   %.0f games/s, %.0f ticks/s\n", games / elapsed, total.ticks / elapsed);
+	if (total.games) {
+		uint64_t seen = 0, median = 0, p99 = 0, longest = 0, sum = 0;
+
+		for (int i = 0; i <= CELLS; i++) {
+			if (!total.length[i]) {
+				continue;
+			}
+			sum += (uint64_t)i * total.length[i];
+			seen += total.length[i];
+			longest = i;
+			if (!median && seen * 2 >= total.games) median = i;
+			if (!p99 && seen * 100 >= total.games * 99) p99 = i;
+		}
+		printf("Game length:  %.1f ticks mean, %.2f presses per tick\n",
+			(double)total.ticks / total.games, (double)total.presses / total.ticks);
+		printf("Final length: mean %.2f, median %" PRIu64 ", 99th %% %" PRIu64 ", max %" PRIu64 "\n",
+			(double)sum / total.games, median, p99, longest);
+		printf("Endings:      %" PRIu64 " game over, %" PRIu64 " won, %" PRIu64 " tick limit\n",
+			total.ended[GAME_OVER], total.ended[GAME_WON], total.ended[PLAYING]);
+	}
+	printf("Failures:     %" PRIu64 "\n", total.failures);
+	for (uint64_t i = 0; i < total.failures && i < MAX_FAILURES; i++) {
+		printf("  seed %" PRIu64 ": %s (replay with -r %" PRIu64 ")\n",
+			total.failed_seed[i], total.failed_why[i], total.failed_seed[i]);
+	}
+
+	free(soak.stats);
+	return total.failures ? 1 : 0;
+}
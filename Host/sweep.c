@@ -0,0 +1,220 @@
+/* Parallel sweep of clock, timer and dwell settings with a Pareto table */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define MAX_VALUES 64
+
+/* One comma separated option value list */
+typedef struct {
+	uint32_t value[MAX_VALUES];
+	uint32_t div[MAX_VALUES];		/* Bus divider for clock setups, "core/div" */
+	int count;
+} List;
+
+/* One point of the grid and its outcome */
+typedef struct {
+	SimConfig cfg;
+	SimReport rep;
+	int pareto;
+} Point;
+
+static Point *points;
+static int npoints;
+static atomic_int next_point;
+static double seconds = 3.0;
+static double press_interval = 0.35;
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -c LIST    core clocks, CORE[/BUSDIV] (default 41943040)\n"
+		"  -w LIST    PIT0 reload values, one tick of the timer wheel (default 4800)\n"
+		"  -g LIST    wheel ticks per game tick (default 1000)\n"
+		"  -r LIST    wheel ticks per display refresh, until the governor measured one (default 1)\n"
+		"  -G         keep the refresh periods of -r, no governor\n"
+		"  -d LIST    delay() inner iterations per column (default 2000)\n"
+		"  -s SEC     simulated time per point (default 3)\n"
+		"  -j N       worker threads (default all CPUs)\n"
+		"  -P         print the Pareto optimal points only\n"
+		"LIST is comma separated, FROM:TO:STEP ranges are allowed.\n",
+		prog);
+	exit(2);
+}
+
+static void parse_list(List *l, char *arg, const char *prog) {
+	l->count = 0;
+	for (char *tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+		unsigned long from, to, step = 1, div = 1;
+		char *slash = strchr(tok, '/');
+
+		if (slash) {
+			div = strtoul(slash + 1, NULL, 0);
+			*slash = '\0';
+		}
+		if (sscanf(tok, "%lu:%lu:%lu", &from, &to, &step) < 2) {
+			to = from = strtoul(tok, NULL, 0);
+		}
+		if (!step || !div) {
+			usage(prog);
+		}
+		for (unsigned long v = from; v <= to; v += step) {
+			if (l->count == MAX_VALUES) {
+				fprintf(stderr, "%s: more than %d values in a list\n", prog, MAX_VALUES);
+				exit(2);
+			}
+			l->value[l->count] = v;
+			l->div[l->count] = div;
+			l->count++;
+		}
+	}
+	if (!l->count) {
+		usage(prog);
+	}
+}
+
+/* Play one grid point with a fixed staircase of turns to probe the input latency */
+static void run_point(Point *p) {
+	static _Thread_local Sim sim;
+	uint64_t interval = (uint64_t)(press_interval * p->cfg.core_hz);
+	uint64_t end = (uint64_t)(seconds * p->cfg.core_hz);
+	Direction turn = RIGHT;
+
+	sim_init(&sim, &p->cfg);
+	for (unsigned k = 0; sim.now + interval <= end; k++) {
+		/* Spread the presses over the interval so the latency is averaged over the tick phase */
+		uint64_t at = sim.now + interval * (k % 7) / 8;
+
+		sim_press(&sim, at, turn);
+		turn = turn == RIGHT ? DOWN : RIGHT;
+		sim_run(&sim, interval);
+	}
+	sim_run(&sim, end - sim.now);
+	sim_report(&sim, &p->rep);
+}
+
+static void *worker(void *arg) {
+	int i;
+
+	(void)arg;
+	while ((i = atomic_fetch_add(&next_point, 1)) < npoints) {
+		run_point(&points[i]);
+	}
+	return NULL;
+}
+
+/* Whether a is at least as good as b in every objective and better in one */
+static int dominates(const SimReport *a, const SimReport *b) {
+	int better = 0;
+
+	if (a->cpu_load > b->cpu_load || a->pixel_rate < b->pixel_rate ||
+		a->latency > b->latency || a->mean_duty < b->mean_duty) {
+		return 0;
+	}
+	better |= a->cpu_load < b->cpu_load;
+	better |= a->pixel_rate > b->pixel_rate;
+	better |= a->latency < b->latency;
+	better |= a->mean_duty > b->mean_duty;
+	return better;
+}
+
+int main(int argc, char *argv[]) {
+	List clocks, wheel, game, refresh, dwell;
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int pareto_only = 0, governed = 1, opt;
+	char def_clock[] = "41943040", def_wheel[] = "4800", def_game[] = "1000", def_refresh[] = "1";
+	char def_dwell[] = "2000";
+
+	parse_list(&clocks, def_clock, argv[0]);
+	parse_list(&wheel, def_wheel, argv[0]);
+	parse_list(&game, def_game, argv[0]);
+	parse_list(&refresh, def_refresh, argv[0]);
+	parse_list(&dwell, def_dwell, argv[0]);
+	while ((opt = getopt(argc, argv, "c:w:g:r:Gd:s:j:P")) != -1) {
+		switch (opt) {
+			case 'c': parse_list(&clocks, optarg, argv[0]); break;
+			case 'w': parse_list(&wheel, optarg, argv[0]); break;
+			case 'g': parse_list(&game, optarg, argv[0]); break;
+			case 'r': parse_list(&refresh, optarg, argv[0]); break;
+			case 'd': parse_list(&dwell, optarg, argv[0]); break;
+			case 's': seconds = atof(optarg); break;
+			case 'j': threads = atol(optarg); break;
+			case 'G': governed = 0; break;
+			case 'P': pareto_only = 1; break;
+			default: usage(argv[0]);
+		}
+	}
+	if (seconds <= press_interval || threads < 1) {
+		usage(argv[0]);
+	}
+
+	npoints = clocks.count * wheel.count * game.count * refresh.count * dwell.count;
+	points = calloc(npoints, sizeof(*points));
+	if (!points) {
+		perror("calloc");
+		return 1;
+	}
+
+	Point *p = points;
+	for (int c = 0; c < clocks.count; c++)
+	for (int w = 0; w < wheel.count; w++)
+	for (int g = 0; g < game.count; g++)
+	for (int r = 0; r < refresh.count; r++)
+	for (int d = 0; d < dwell.count; d++, p++) {
+		sim_default_config(&p->cfg);
+		p->cfg.governed = governed;
+		p->cfg.core_hz = clocks.value[c];
+		p->cfg.bus_div = clocks.div[c];
+		p->cfg.ldval = wheel.value[w];
+		p->cfg.period[EVENT_TICK] = game.value[g];
+		p->cfg.period[EVENT_REFRESH] = refresh.value[r];
+		p->cfg.dwell = dwell.value[d];
+	}
+
+	/* Every point is an independent simulator, workers just pull the next index */
+	if (threads > npoints) {
+		threads = npoints;
+	}
+	pthread_t tid[threads];
+	for (long t = 0; t < threads; t++) {
+		pthread_create(&tid[t], NULL, worker, NULL);
+	}
+	for (long t = 0; t < threads; t++) {
+		pthread_join(tid[t], NULL);
+	}
+
+	for (int i = 0; i < npoints; i++) {
+		points[i].pareto = 1;
+		for (int j = 0; j < npoints && points[i].pareto; j++) {
+			if (j != i && dominates(&points[j].rep, &points[i].rep)) {
+				points[i].pareto = 0;
+			}
+		}
+	}
+
+	printf("core_hz,bus_div,pit0_ldval,game_ticks,refresh_ticks,dwell,tick_ms,frame_hz,pixel_hz,"
+		"cpu_load_pct,latency_ms,max_latency_ms,mean_duty_pct,nonuniformity_pct,pareto\n");
+	for (int i = 0; i < npoints; i++) {
+		const SimConfig *cfg = &points[i].cfg;
+		const SimReport *rep = &points[i].rep;
+
+		if (pareto_only && !points[i].pareto) {
+			continue;
+		}
+		printf("%u,%u,%u,%u,%u,%u,%.3f,%.1f,%.1f,%.2f,%.2f,%.2f,%.2f,%.2f,%d\n",
+			cfg->core_hz, cfg->bus_div, cfg->ldval, cfg->period[EVENT_TICK], cfg->period[EVENT_REFRESH], cfg->dwell,
+			1e3 * (cfg->ldval + 1.0) * cfg->period[EVENT_TICK] * cfg->bus_div / cfg->core_hz,
+			rep->frame_rate, rep->pixel_rate, 100 * rep->cpu_load,
+			1e3 * rep->latency, 1e3 * rep->max_latency,
+			100 * rep->mean_duty, 100 * rep->nonuniformity, points[i].pareto);
+	}
+
+	free(points);
+	return 0;
+}
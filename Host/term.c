@@ -0,0 +1,219 @@
+/* Live ANSI terminal view of the simulated LED matrix */
+
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+/*
+ * The matrix is drawn the way it is mounted on the board: the 16 columns run
+ * top to bottom and row 0 is on the right, so the buttons move the snake the
+ * way they are labelled.
+ */
+#define SCREEN_W ROWS
+#define SCREEN_H COLS
+#define TOP 2
+
+static struct termios saved;
+static int raw;
+static volatile sig_atomic_t quit;
+
+static void restore(void) {
+	if (raw) {
+		tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+	}
+	fputs("\033[0m\033[?25h\n", stdout);
+	fflush(stdout);
+}
+
+static void on_signal(int sig) {
+	(void)sig;
+	quit = 1;
+}
+
+static double now_seconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Output is collected and written once per screen update */
+static char out[16384];
+static size_t out_len;
+
+static void flush_out(void) {
+	if (out_len && write(STDOUT_FILENO, out, out_len) < 0) {
+		quit = 1;
+	}
+	out_len = 0;
+}
+
+static void emit(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void emit(const char *fmt, ...) {
+	va_list ap;
+	int n;
+
+	if (out_len >= sizeof(out)) {
+		return;
+	}
+	va_start(ap, fmt);
+	n = vsnprintf(out + out_len, sizeof(out) - out_len, fmt, ap);
+	va_end(ap);
+	if (n > 0) {
+		out_len += (size_t)n < sizeof(out) - out_len ? (size_t)n : sizeof(out) - out_len - 1;
+	}
+	if (out_len >= sizeof(out) / 2) {
+		flush_out();
+	}
+}
+
+/* Translate pending key presses into button presses */
+static void read_keys(Sim *s) {
+	unsigned char buf[64];
+	ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+
+	for (ssize_t i = 0; i < n; i++) {
+		int key = buf[i];
+
+		/* Arrow keys arrive as ESC [ A..D */
+		if (key == 27 && i + 2 < n && buf[i + 1] == '[') {
+			key = "wsdaX"[buf[i + 2] >= 'A' && buf[i + 2] <= 'D' ? buf[i + 2] - 'A' : 4];
+			i += 2;
+		}
+
+		switch (key) {
+			case 'w': case 'k': sim_press(s, s->now, UP); break;
+			case 's': case 'j': sim_press(s, s->now, DOWN); break;
+			case 'a': case 'h': sim_press(s, s->now, LEFT); break;
+			case 'd': case 'l': sim_press(s, s->now, RIGHT); break;
+			case ' ': case 'p': sim_press(s, s->now, STOP); break;
+			case 'q': case 3: quit = 1; break;
+		}
+	}
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [-x MULT] [-t SEC]\n"
+		"  -x MULT    fast-forward multiplier (default 1)\n"
+		"  -t SEC     quit after SEC seconds of wall time\n"
+		"Keys: arrows/WASD/HJKL steer, space pauses, q quits.\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	static Sim sim;
+	SimConfig cfg;
+	double mult = 1.0, limit = 0.0;
+	uint8_t shown[COLS];
+	int opt;
+
+	while ((opt = getopt(argc, argv, "x:t:")) != -1) {
+		switch (opt) {
+			case 'x': mult = atof(optarg); break;
+			case 't': limit = atof(optarg); break;
+			default: usage(argv[0]);
+		}
+	}
+	if (mult <= 0) {
+		usage(argv[0]);
+	}
+
+	if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0) {
+		struct termios t = saved;
+
+		t.c_lflag &= ~(ICANON | ECHO | ISIG);
+		t.c_cc[VMIN] = 0;
+		t.c_cc[VTIME] = 0;
+		tcsetattr(STDIN_FILENO, TCSANOW, &t);
+		raw = 1;
+	}
+	atexit(restore);
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	sim_default_config(&cfg);
+	sim_init(&sim, &cfg);
+
+	/* Full redraw once, afterwards only the cells that changed */
+	memset(shown, 0, sizeof(shown));
+	emit("\033[?25l\033[2J\033[H+");
+	for (int x = 0; x < SCREEN_W; x++) {
+		emit("--");
+	}
+	emit("+\r\n");
+	for (int y = 0; y < SCREEN_H; y++) {
+		emit("|%*s|\r\n", 2 * SCREEN_W, "");
+	}
+	emit("+");
+	for (int x = 0; x < SCREEN_W; x++) {
+		emit("--");
+	}
+	emit("+\r\n");
+	flush_out();
+
+	double start = now_seconds(), last = start, shown_at = start;
+	uint64_t frames_shown = 0, updates = 0;
+	double fps = 0.0;
+
+	while (!quit) {
+		struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+
+		/* Wake for key presses, otherwise redraw at about 100 Hz */
+		if (poll(&pfd, raw ? 1 : 0, 10) > 0) {
+			read_keys(&sim);
+		}
+
+		double t = now_seconds();
+		double dt = t - last;
+		last = t;
+		if (dt > 0.1) {
+			dt = 0.1;
+		}
+		sim_run(&sim, (uint64_t)(dt * mult * cfg.core_hz));
+
+		for (int col = 0; col < COLS; col++) {
+			uint8_t changed = shown[col] ^ sim.frame[col];
+
+			for (int row = 0; changed; row++, changed >>= 1) {
+				if (!(changed & 1)) {
+					continue;
+				}
+				int on = (sim.frame[col] >> row) & 1;
+				emit("\033[%d;%dH%s", TOP + col, 2 + 2 * (SCREEN_W - 1 - row),
+					on ? "\033[1;31m##\033[0m" : "  ");
+				updates++;
+			}
+			shown[col] = sim.frame[col];
+		}
+
+		if (t - shown_at >= 0.5) {
+			fps = (sim.frames - frames_shown) / (t - shown_at);
+			frames_shown = sim.frames;
+			shown_at = t;
+		}
+		emit("\033[%d;1H\033[Ksim %.1f s  x%g  %.0f frames/s  %llu cell updates  length %u%s",
+			TOP + SCREEN_H + 1, sim.now / (double)cfg.core_hz, mult, fps,
+			(unsigned long long)updates, sim.snake.length,
+			sim.snake.state == GAME_OVER ? "  [game over]" : sim.snake.state == GAME_WON ? "  [won]" :
+			sim.snake.dir == STOP ? "  [paused]" : "");
+		flush_out();
+
+		if (limit > 0 && t - start >= limit) {
+			break;
+		}
+	}
+
+	emit("\033[%d;1H", TOP + SCREEN_H + 2);
+	flush_out();
+	return 0;
+}
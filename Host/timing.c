@@ -0,0 +1,133 @@
+/* Refresh rate, duty cycle and flicker report for the multiplexed LED matrix */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "display.h"
+#include "sim.h"
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -c HZ      core clock (default 41943040)\n"
+		"  -b DIV     core/bus clock divider (default 1)\n"
+		"  -w LDVAL   PIT0 reload value, one tick of the timer wheel (default 4800)\n"
+		"  -g TICKS   wheel ticks per game tick (default 1000)\n"
+		"  -r TICKS   wheel ticks per display refresh, until the governor measured one (default 1)\n"
+		"  -G         keep the refresh period of -r, no governor\n"
+		"  -d N       delay() inner iterations per column (default firmware value)\n"
+		"  -l CYCLES  cycles per inner delay() iteration (default 10)\n"
+		"  -s SEC     simulated time (default 5)\n"
+		"  -f HZ      flicker threshold (default 100)\n"
+		"  -p         keep the snake paused\n"
+		"  -h         print this help\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	SimConfig cfg;
+	double seconds = 5.0, threshold = 100.0;
+	int paused = 0, opt;
+
+	sim_default_config(&cfg);
+	while ((opt = getopt(argc, argv, "c:b:w:g:r:Gd:l:s:f:ph")) != -1) {
+		switch (opt) {
+			case 'c': cfg.core_hz = strtoul(optarg, NULL, 0); break;
+			case 'b': cfg.bus_div = strtoul(optarg, NULL, 0); break;
+			case 'w': cfg.ldval = strtoul(optarg, NULL, 0); break;
+			case 'g': cfg.period[EVENT_TICK] = strtoul(optarg, NULL, 0); break;
+			case 'r': cfg.period[EVENT_REFRESH] = strtoul(optarg, NULL, 0); break;
+			case 'G': cfg.governed = 0; break;
+			case 'd': cfg.dwell = strtoul(optarg, NULL, 0); break;
+			case 'l': cfg.loop_cycles = strtoul(optarg, NULL, 0); break;
+			case 's': seconds = atof(optarg); break;
+			case 'f': threshold = atof(optarg); break;
+			case 'p': paused = 1; break;
+			default: usage(argv[0]);
+		}
+	}
+	if (!cfg.core_hz || !cfg.bus_div || !cfg.period[EVENT_TICK] || !cfg.period[EVENT_REFRESH] || seconds <= 0 ||
+		threshold <= 0) {
+		usage(argv[0]);
+	}
+
+	static Sim sim;
+	SimReport rep;
+	double hz = cfg.core_hz;
+
+	sim_init(&sim, &cfg);
+	if (paused) {
+		sim_press(&sim, 0, STOP);
+	}
+	sim_run(&sim, (uint64_t)(seconds * hz));
+	sim_report(&sim, &rep);
+
+	/* Split the measured display_frame() time into the columns it visits, the lit ones, and the dark rest */
+	unsigned int lit = __builtin_popcount(sim.published.used);
+	double frame_cycles = sim.frames ? (double)sim.event_busy[EVENT_REFRESH] / sim.frames : 0.0;
+	double share = lit * DISPLAY_BOOST >= COLS ? 1.0 : (double)DISPLAY_BOOST / COLS * lit;
+	double column_cycles = lit ? (frame_cycles - cfg.take_cycles - cfg.clear_cycles) * share / lit : 0.0;
+
+	printf("Core clock:       %.2f MHz, bus clock %.2f MHz\n", hz / 1e6, hz / cfg.bus_div / 1e6);
+	printf("PIT0 wheel tick:  %.3f us (LDVAL %u)\n", 1e6 * sim.pit_period / hz, cfg.ldval);
+	printf("Game tick:        %.3f ms (%u wheel ticks)\n", 1e3 * sim.event_period[EVENT_TICK] / hz,
+		cfg.period[EVENT_TICK]);
+	if (cfg.governed) {
+		printf("Refresh:          governed, %u wheel ticks at the end (%.3f ms), a refresh takes %u\n",
+			sim.governor.period, 1e3 * sim.governor.period * sim.pit_period / hz, sim.governor.busy);
+	} else {
+		printf("Refresh:          %.3f us (%u wheel ticks)\n", 1e6 * sim.event_period[EVENT_REFRESH] / hz,
+			cfg.period[EVENT_REFRESH]);
+	}
+	printf("Dwell per column: %.1f us, %u columns lit at the end\n", 1e6 * column_cycles / hz, lit);
+	printf("Simulated:        %.2f s, snake %s\n\n", seconds, paused ? "paused" : "moving");
+
+	printf("Frame rate:       %.1f Hz (%llu frames)\n", rep.frame_rate, (unsigned long long)sim.frames);
+	if (rep.worst_cell[0] >= 0) {
+		printf("Slowest pixel:    row %d col %d, %.1f Hz\n",
+			rep.worst_cell[0], rep.worst_cell[1], rep.pixel_rate);
+		printf("Moved pixel:      %.1f Hz over the gap each change of the lit columns leaves\n", rep.layout_rate);
+	}
+	printf("Address edges:    %.2f per frame, %.2f per column selected\n",
+		sim.frames ? (double)sim.address_edges / sim.frames : 0.0,
+		sim.selects ? (double)sim.address_edges / sim.selects : 0.0);
+	printf("PIT overruns:     %llu\n", (unsigned long long)sim.overruns);
+	printf("Deadline misses:  tick %lu, refresh %lu of %lu expiries\n",
+		(unsigned long)sim.wheel.timer[EVENT_TICK].misses, (unsigned long)sim.wheel.timer[EVENT_REFRESH].misses,
+		(unsigned long)sim.wheel.expired);
+	printf("ISR load:         PORTE %.2f %%, PIT0 %.2f %%\n", 100 * rep.load[SIM_PORTE], 100 * rep.load[SIM_PIT0]);
+	printf("Main loop load:   tick %.2f %%, refresh %.2f %%, awake %.2f %%\n",
+		100 * rep.event_load[EVENT_TICK], 100 * rep.event_load[EVENT_REFRESH], 100 * rep.cpu_load);
+	printf("Stopped:          %.2f %% in %llu stops%s\n", 100 * rep.stopped, (unsigned long long)sim.stops,
+		sim.stops ? ", blanked" : "");
+	printf("MCU current:      %.2f mA mean, LEDs excluded\n", rep.current);
+	if (rep.cells) {
+		printf("Duty cycle:       min %.2f %%, mean %.2f %%, max %.2f %%\n",
+			100 * rep.min_duty, 100 * rep.mean_duty, 100 * rep.max_duty);
+		printf("Non-uniformity:   %.1f %% (max - min) / max\n", 100 * rep.nonuniformity);
+	}
+	printf("Ghost light:      %.2f %% of lit time on empty cells\n", 100 * rep.ghost);
+	printf("\n");
+
+	printf("Duty cycle per pixel (%%), '.' never occupied:\n");
+	for (int r = 0; r < ROWS; r++) {
+		for (int c = 0; c < COLS; c++) {
+			double duty = sim_duty(&sim, r, c);
+
+			if (duty < 0) {
+				printf("    .");
+			} else {
+				printf(" %4.1f", 100 * duty);
+			}
+		}
+		printf("\n");
+	}
+
+	if (rep.frame_rate < threshold || rep.pixel_rate < threshold || rep.layout_rate < threshold) {
+		printf("\nFLICKER: refresh below %.0f Hz\n", threshold);
+		return 1;
+	}
+	return 0;
+}
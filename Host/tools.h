@@ -0,0 +1,31 @@
+#ifndef TOOLS_H
+#define TOOLS_H
+
+#include <stdint.h>
+#include <time.h>
+
+/* Small helpers the host tools share */
+
+/* Pseudo random sequence for the players and benchmarks, r must not be 0 */
+static inline uint32_t xorshift(uint32_t *r) {
+	*r ^= *r << 13;
+	*r ^= *r >> 17;
+	*r ^= *r << 5;
+	return *r;
+}
+
+/* 64-bit seeds and schedules from any starting value, 0 included */
+static inline uint64_t splitmix64(uint64_t *x) {
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+/* Seconds from t0 to t1 of the same clock */
+static inline double seconds(const struct timespec *t0, const struct timespec *t1) {
+	return (t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) * 1e-9;
+}
+
+#endif /* TOOLS_H */
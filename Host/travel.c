@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "travel.h"
+
+int travel_init(Travel *t, const SimConfig *cfg, uint64_t interval, unsigned slots) {
+	memset(t, 0, sizeof(*t));
+	if (!interval || !slots || !(t->ring = malloc(sizeof(TravelSnapshot) * slots))) {
+		return -1;
+	}
+	t->slots = slots;
+	sim_init(&t->run, cfg);
+	t->period = interval * t->run.event_period[EVENT_TICK];
+	t->next = 0;
+	return 0;
+}
+
+void travel_free(Travel *t) {
+	free(t->ring);
+	free(t->log);
+	t->ring = NULL;
+	t->log = NULL;
+}
+
+/* Forget the presses before the oldest snapshot, moving the rest down once they are half the log */
+static void travel_trim(Travel *t) {
+	uint64_t keep = t->ring[t->oldest].presses;
+	size_t drop = keep - t->log_first;
+
+	if (drop && drop * 2 >= t->log_count) {
+		memmove(t->log, t->log + drop, (t->log_count - drop) * sizeof(TravelPress));
+		t->log_count -= drop;
+		t->log_first = keep;
+	}
+}
+
+static void travel_snapshot(Travel *t) {
+	unsigned slot = (t->oldest + t->count) % t->slots;
+
+	if (t->count == t->slots) {
+		t->oldest = (t->oldest + 1) % t->slots;
+	} else {
+		t->count++;
+	}
+	t->ring[slot].sim = t->run;
+	t->ring[slot].presses = t->log_first + t->log_count;
+	travel_trim(t);
+}
+
+int travel_press(Travel *t, uint64_t at, Direction dir) {
+	if (t->log_count == t->log_cap) {
+		size_t cap = t->log_cap ? t->log_cap * 2 : 256;
+		TravelPress *log = realloc(t->log, cap * sizeof(TravelPress));
+
+		if (!log) {
+			return -1;
+		}
+		t->log = log;
+		t->log_cap = cap;
+	}
+	if (sim_press(&t->run, at, dir)) {
+		return -1;
+	}
+	t->log[t->log_count++] = (TravelPress){ t->run.now, at, dir };
+	return 0;
+}
+
+/*
+ * sim_run() stops between handlers, so a run split at any times reaches
+ * the same state as long as every part ends at an absolute time. That is
+ * what lets a seek stop at other times than the run did.
+ */
+static void run_until(Sim *s, uint64_t until) {
+	if (s->now < until) {
+		sim_run(s, until - s->now);
+	}
+}
+
+void travel_run(Travel *t, uint64_t until) {
+	do {
+		if (t->run.now >= t->next) {
+			travel_snapshot(t);
+			while (t->next <= t->run.now) {
+				t->next += t->period;
+			}
+		}
+		run_until(&t->run, until < t->next ? until : t->next);
+	} while (t->run.now < until);
+}
+
+uint64_t travel_tick_time(const Travel *t, uint64_t tick) {
+	return tick * t->run.event_period[EVENT_TICK];
+}
+
+const Sim *travel_seek(Travel *t, uint64_t tick) {
+	uint64_t when = travel_tick_time(t, tick);
+	const TravelSnapshot *from = NULL;
+
+	if (when > t->run.now) {
+		return NULL;
+	}
+	/* Snapshots are in time order, find the last one not after the tick */
+	unsigned lo = 0, hi = t->count;
+	while (lo < hi) {
+		unsigned mid = (lo + hi) / 2;
+
+		if (t->ring[(t->oldest + mid) % t->slots].sim.now <= when) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (!lo) {
+		return NULL;
+	}
+	from = &t->ring[(t->oldest + lo - 1) % t->slots];
+
+	t->view = from->sim;
+	for (uint64_t i = from->presses; i < t->log_first + t->log_count; i++) {
+		const TravelPress *p = &t->log[i - t->log_first];
+
+		/* Presses the run made at the time the view stops at are taken too */
+		run_until(&t->view, p->queued < when ? p->queued : when);
+		if (p->queued > t->view.now) {
+			break;
+		}
+		sim_press(&t->view, p->at, p->dir);
+	}
+	run_until(&t->view, when);
+	return &t->view;
+}
+
+size_t travel_memory(const Travel *t) {
+	return sizeof(TravelSnapshot) * t->slots + sizeof(TravelPress) * t->log_cap;
+}
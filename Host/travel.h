@@ -0,0 +1,69 @@
+#ifndef TRAVEL_H
+#define TRAVEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+/* A button press as the run made it, queued when the board was at time queued */
+typedef struct {
+	uint64_t queued;
+	uint64_t at;
+	Direction dir;
+} TravelPress;
+
+/* The whole board at one time and how many presses had been queued by then */
+typedef struct {
+	Sim sim;
+	uint64_t presses;
+} TravelSnapshot;
+
+/*
+ * Time travel over a simulated run. The run takes a snapshot of the board
+ * every interval game ticks into a ring of slots and logs its presses. A
+ * seek copies the latest snapshot at or before the wanted tick into a
+ * separate board and runs it forward with the logged presses, so it costs
+ * at most one interval of simulation however long the run has been, and
+ * the run itself is not disturbed. Snapshots that fall out of the ring take
+ * the presses before them along; ticks before the oldest one are gone.
+ */
+typedef struct {
+	Sim run;						/* The board going forward */
+	Sim view;						/* The board at the last seek */
+	uint64_t period;				/* Core cycles between snapshots */
+	uint64_t next;					/* Time of the next snapshot */
+
+	TravelSnapshot *ring;
+	unsigned slots, oldest, count;
+
+	TravelPress *log;				/* Presses since the oldest snapshot */
+	uint64_t log_first;				/* Number of the press in log[0] */
+	size_t log_count, log_cap;
+} Travel;
+
+/* Start a run with snapshots every interval game ticks, keeping the last slots of them */
+int travel_init(Travel *t, const SimConfig *cfg, uint64_t interval, unsigned slots);
+void travel_free(Travel *t);
+
+/* Queue a press on the run, as sim_press() */
+int travel_press(Travel *t, uint64_t at, Direction dir);
+
+/* Run until the board reaches an absolute time in core cycles, taking the snapshots that fall due */
+void travel_run(Travel *t, uint64_t until);
+
+/* Time in core cycles at which game tick number tick is raised */
+uint64_t travel_tick_time(const Travel *t, uint64_t tick);
+
+/*
+ * Bring the view to the time of game tick number tick, NULL if that is
+ * before the oldest snapshot or after the run. The view may stop a few
+ * cycles later when a handler is running at that time, and it holds the
+ * presses the run queued up to the time it stops at.
+ */
+const Sim *travel_seek(Travel *t, uint64_t tick);
+
+/* Bytes held by the snapshot ring and the press log */
+size_t travel_memory(const Travel *t);
+
+#endif /* TRAVEL_H */
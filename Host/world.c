@@ -0,0 +1,156 @@
+/*
+ * The scrolling window of a world larger than the matrix. Built once per
+ * world size with ROWS and COLS defined, plays greedy games and checks every
+ * frame the display would draw against the world cell by cell.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "governor.h"
+#include "play.h"
+#include "snake.h"
+#include "tools.h"
+#include "viewport.h"
+#include "wheel.h"
+
+#define BUS_CLOCK 41943040.0		/* Hz, PIT clock on the board */
+
+/* Refresh period of a still picture, the governor's GOVERNOR_STILL wheel ticks */
+#define STILL_PERIOD (GOVERNOR_STILL * (WHEEL_LDVAL + 1) / BUS_CLOCK)
+
+static void usage(const char *prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n TICKS   game ticks to run (default 2000000)\n",
+		prog);
+	exit(2);
+}
+
+/* Frame built pixel by pixel from the world, what viewport_columns() must match */
+static void reference(const Snake *s, const Viewport *v, uint8_t columns[MATRIX_COLS]) {
+	for (unsigned int c = 0; c < MATRIX_COLS; c++) {
+		columns[c] = 0;
+		for (unsigned int r = 0; r < MATRIX_ROWS; r++) {
+			unsigned int row = (v->row + r) % ROWS, col = (v->col + c) % COLS;
+			unsigned int cell = CELL(row, col);
+
+			if ((s->occupied[cell / 64] >> (cell % 64)) & 1 ||
+				(cell == s->food && snake_has_food(s))) {
+				columns[c] |= 1u << r;
+			}
+		}
+	}
+}
+
+/* Whether the head is in the window, and inside its margins unless a wall is closer */
+static const char *check_window(const Snake *s, const Viewport *v) {
+	unsigned int head = snake_segment(s, 0);
+	unsigned int row = (CELL_ROW(head) + ROWS - v->row) % ROWS;
+	unsigned int col = (CELL_COL(head) + COLS - v->col) % COLS;
+
+	if (row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+		return "head outside the window";
+	}
+	if (SNAKE_WALLS ? v->row > ROWS - MATRIX_ROWS || v->col > COLS - MATRIX_COLS : v->row >= ROWS || v->col >= COLS) {
+		return "window outside the world";
+	}
+	/* Only a wall may hold the window back */
+	if ((row < VIEWPORT_ROW_MARGIN && !(SNAKE_WALLS && v->row == 0)) ||
+		(row >= MATRIX_ROWS - VIEWPORT_ROW_MARGIN && !(SNAKE_WALLS && v->row == ROWS - MATRIX_ROWS)) ||
+		(col < VIEWPORT_COL_MARGIN && !(SNAKE_WALLS && v->col == 0)) ||
+		(col >= MATRIX_COLS - VIEWPORT_COL_MARGIN && !(SNAKE_WALLS && v->col == COLS - MATRIX_COLS))) {
+		return "head inside the margins";
+	}
+	return NULL;
+}
+
+int main(int argc, char *argv[]) {
+	uint64_t ticks = 2000000, frames = 0, games = 0;
+	uint32_t r = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+			case 'n': ticks = strtoull(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+
+	static Snake s;
+	Viewport v = { 0, 0 };
+	uint8_t got[MATRIX_COLS], want[MATRIX_COLS];
+	const char *why;
+
+	/* Correctness, every tick of every game */
+	init_snake(&s, 1);
+	viewport_follow(&v, &s);
+	for (uint64_t t = 0; t < ticks; t++) {
+		steer_snake(&s, greedy_steer(&s, xorshift(&r)));
+		update_snake(&s);
+		viewport_follow(&v, &s);
+
+		if (s.state == PLAYING && (why = check_window(&s, &v))) {
+			printf("tick %" PRIu64 ": %s at %u,%u\n", t, why, v.row, v.col);
+			return 1;
+		}
+		viewport_columns(&s, &v, got);
+		reference(&s, &v, want);
+		for (unsigned int c = 0; c < MATRIX_COLS; c++) {
+			if (got[c] != want[c]) {
+				printf("tick %" PRIu64 ": column %u is %02x, world has %02x, window %u,%u\n", t, c, got[c], want[c],
+					v.row, v.col);
+				return 1;
+			}
+		}
+		frames++;
+		if (t % 1024 == 0 && (why = check_snake(&s))) {
+			printf("tick %" PRIu64 ": %s\n", t, why);
+			return 1;
+		}
+		if (s.state != PLAYING) {
+			games++;
+			init_snake(&s, r);
+		}
+	}
+
+	/* Cost of the game tick with the scroll, and of one frame extraction */
+	struct timespec t0, t1;
+	uint64_t lit = 0;
+
+	init_snake(&s, 1);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint64_t t = 0; t < ticks; t++) {
+		steer_snake(&s, greedy_steer(&s, xorshift(&r)));
+		update_snake(&s);
+		viewport_follow(&v, &s);
+		if (s.state != PLAYING) {
+			init_snake(&s, r);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double tick_ns = seconds(&t0, &t1) / ticks * 1e9;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint64_t t = 0; t < ticks; t++) {
+		/* Sweep the window over the world so no frame repeats the last */
+		v.row = t % (SNAKE_WALLS ? ROWS - MATRIX_ROWS + 1 : ROWS);
+		v.col = t / ROWS % (SNAKE_WALLS ? COLS - MATRIX_COLS + 1 : COLS);
+		viewport_columns(&s, &v, got);
+		lit += __builtin_popcount(got[t % MATRIX_COLS]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double frame_ns = seconds(&t0, &t1) / ticks * 1e9;
+
+	printf("World:        %dx%d, %s, %d bitboard words, %zu byte Snake\n", COLS, ROWS,
+		SNAKE_WALLS ? "walls" : "wrapping", BOARD_WORDS, sizeof(Snake));
+	printf("Checked:      %" PRIu64 " frames in %" PRIu64 " games, all match the world\n", frames, games);
+	printf("Tick:         %.1f ns with steering and scroll\n", tick_ns);
+	printf("Frame:        %.1f ns to extract %d columns, still refresh period %.2f ms, %.2f lit LEDs per column\n",
+		frame_ns, MATRIX_COLS, STILL_PERIOD * 1e3, (double)lit / ticks);
+	return 0;
+}
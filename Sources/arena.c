@@ -0,0 +1,223 @@
+#include <string.h>
+
+#include "arena.h"
+
+static int occupies(const Arena *a, unsigned int cell) {
+	return (a->occupied[cell / 64] >> (cell % 64)) & 1;
+}
+
+static void set_cell(Arena *a, unsigned int cell, unsigned int i) {
+	a->occupied[cell / 64] |= 1ull << (cell % 64);
+	a->owner[cell] = i;
+}
+
+static void clear_cell(Arena *a, unsigned int cell) {
+	a->occupied[cell / 64] &= ~(1ull << (cell % 64));
+}
+
+static unsigned int tail_of(const Rival *r) {
+	return r->body[(r->head + SNAKE_MAX_LENGTH - (r->length - 1)) % SNAKE_MAX_LENGTH];
+}
+
+void init_arena(Arena *a, unsigned int n, uint32_t seed) {
+	a->n = n;
+	a->alive = n;
+	a->paused = 0;
+	a->winner = ARENA_NONE;
+	a->state = PLAYING;
+	a->used = n * SNAKE_LENGTH;
+	a->seed = seed ? seed : 1;
+
+	for (int w = 0; w < BOARD_WORDS; w++) {
+		a->occupied[w] = 0;
+	}
+
+	/* Spread the snakes over the rows, each laid out like the single player snake */
+	for (unsigned int i = 0; i < n; i++) {
+		Rival *r = &a->snakes[i];
+
+		r->length = SNAKE_LENGTH;
+		r->head = SNAKE_LENGTH - 1;
+		r->dir = DOWN;
+		r->moved = DOWN;
+		r->alive = 1;
+		for (unsigned int j = 0; j < SNAKE_LENGTH; j++) {
+			r->body[j] = CELL(i * ROWS / n, j);
+			set_cell(a, r->body[j], i);
+		}
+	}
+
+	a->food = board_free_cell(a->occupied, next_random(&a->seed) % (CELLS - a->used));
+}
+
+/*
+ * Move every snake one step at once. Tails leave first, so a head may
+ * follow any tail as it does its own. Heads are then tested against the
+ * bodies, and the heads that get through claim their cells in the owner
+ * map, where a second claim on a cell finds the first. Each snake costs
+ * a constant number of bit tests whatever the length of the others.
+ */
+void update_arena(Arena *a) {
+	unsigned int target[ARENA_SNAKES];
+	uint32_t moving = 0, grow = 0, crashed = 0;
+
+	if (a->paused || a->state != PLAYING) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < a->n; i++) {
+		Rival *r = &a->snakes[i];
+
+		if (!r->alive) {
+			continue;
+		}
+		moving |= 1u << i;
+		target[i] = cell_step(r->body[r->head], r->dir);
+		if (target[i] == a->food) {
+			grow |= 1u << i;
+		} else {
+			clear_cell(a, tail_of(r));
+		}
+	}
+
+	/* A head on a body crashes whoever the body belongs to */
+	for (unsigned int i = 0; i < a->n; i++) {
+		if ((moving >> i) & 1 && (target[i] == CELLS || occupies(a, target[i]))) {
+			crashed |= 1u << i;
+		}
+	}
+
+	/* Only heads have claimed a cell since the bodies were tested, two heads crash each other */
+	for (unsigned int i = 0; i < a->n; i++) {
+		if (!(((moving & ~crashed) >> i) & 1)) {
+			continue;
+		}
+		if (occupies(a, target[i])) {
+			crashed |= 1u << i | 1u << a->owner[target[i]];
+		} else {
+			set_cell(a, target[i], i);
+		}
+	}
+
+	/* Crashed snakes leave the board, but not the cells other heads took from them */
+	for (unsigned int i = 0; i < a->n; i++) {
+		Rival *r = &a->snakes[i];
+
+		if (!((crashed >> i) & 1)) {
+			continue;
+		}
+		if (target[i] != CELLS && arena_owner(a, target[i]) == i) {
+			clear_cell(a, target[i]);
+		}
+		for (unsigned int j = 0; j < r->length; j++) {
+			unsigned int cell = r->body[(r->head + SNAKE_MAX_LENGTH - j) % SNAKE_MAX_LENGTH];
+
+			if (a->owner[cell] == i) {
+				clear_cell(a, cell);
+			}
+		}
+		a->used -= r->length;
+		r->alive = 0;
+		a->alive--;
+	}
+
+	/* The rest advance, at most one of them onto the food since two would have met */
+	int eater = -1;
+
+	for (unsigned int i = 0; i < a->n; i++) {
+		Rival *r = &a->snakes[i];
+
+		if (!(((moving & ~crashed) >> i) & 1)) {
+			continue;
+		}
+		r->head = (r->head + 1) % SNAKE_MAX_LENGTH;
+		r->body[r->head] = target[i];
+		r->moved = r->dir;
+		if ((grow >> i) & 1) {
+			r->length++;
+			a->used++;
+			eater = i;
+		}
+	}
+
+	if (a->n > 1 ? a->alive <= 1 : a->alive == 0) {
+		a->state = GAME_OVER;
+		for (unsigned int i = 0; i < a->n; i++) {
+			if (a->snakes[i].alive) {
+				a->winner = i;
+			}
+		}
+	} else if (eater >= 0) {
+		if (a->snakes[eater].length == SNAKE_MAX_LENGTH) {
+			a->state = GAME_WON;
+			a->winner = eater;
+		} else if (a->used == CELLS) {
+			/* No cell left for the food, the longest snake takes the game */
+			a->state = GAME_WON;
+			a->winner = eater;
+			for (unsigned int i = 0; i < a->n; i++) {
+				if (a->snakes[i].alive && a->snakes[i].length > a->snakes[a->winner].length) {
+					a->winner = i;
+				}
+			}
+		} else {
+			a->food = board_free_cell(a->occupied, next_random(&a->seed) % (CELLS - a->used));
+		}
+	}
+}
+
+/* React to a button press of snake i, STOP pauses the whole game */
+void steer_arena(Arena *a, unsigned int i, Direction dir) {
+	Rival *r = &a->snakes[i];
+
+	/* Any button starts a new game once the last one has ended */
+	if (a->state != PLAYING) {
+		init_arena(a, a->n, a->seed);
+		return;
+	}
+
+	if (dir == STOP) {
+		a->paused = !a->paused;
+	} else if (!a->paused && r->alive && dir != RIGHT + LEFT - r->moved) {
+		r->dir = dir;
+	}
+}
+
+void arena_view(const Arena *a, unsigned int i, Snake *view) {
+	const Rival *r = &a->snakes[i];
+
+	memcpy(view->body, r->body, sizeof(r->body));
+	memcpy(view->occupied, a->occupied, sizeof(a->occupied));
+	view->head = r->head;
+	view->length = r->length;
+	view->food = a->food;
+	view->state = a->state;
+	view->dir = r->dir;
+	view->dir_before_stop = r->dir;
+	view->moved = r->moved;
+	view->seed = a->seed;
+	view->level = NULL;
+	view->walls = 0;
+}
+
+#if ROWS < 32
+unsigned int arena_column(const Arena *a, unsigned int col, uint32_t snakes) {
+	unsigned int bits = board_column(a->occupied, col);
+
+	/* Leave out the cells of the snakes not in the mask */
+	if (~snakes & (uint32_t)((1ull << a->n) - 1)) {
+		for (unsigned int b = bits; b; b &= b - 1) {
+			unsigned int row = __builtin_ctz(b);
+
+			if (!((snakes >> a->owner[CELL(row, col)]) & 1)) {
+				bits &= ~(1u << row);
+			}
+		}
+	}
+
+	if (a->used < CELLS && CELL_COL(a->food) == col) {
+		bits |= 1u << CELL_ROW(a->food);
+	}
+	return bits;
+}
+#endif
@@ -0,0 +1,72 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+
+#include "snake.h"
+
+/* Most snakes on one board, each starts on its own row */
+#ifndef ARENA_SNAKES
+#define ARENA_SNAKES 2
+#endif
+
+#if ARENA_SNAKES > ROWS || ARENA_SNAKES > 32
+#error "every snake needs a starting row and a bit in a snake mask"
+#endif
+
+/* Owner of a free cell and winner of a game nobody won */
+#define ARENA_NONE 0xFF
+
+/* One snake of an arena, a ring buffer like the single player snake */
+typedef struct {
+	Cell body[SNAKE_MAX_LENGTH];		/* Ring buffer of cells, body[head] is the head */
+	Length head;						/* Ring buffer index of the head */
+	Length length;						/* Current number of segments */
+	Direction dir;						/* Current direction of movement */
+	Direction moved;					/* Direction of the last step taken */
+	uint8_t alive;						/* Cleared when the snake crashes */
+} Rival;
+
+/*
+ * Several snakes on one board. The bodies share a single occupancy
+ * bitboard and the owner map names the snake on each covered cell, so a
+ * head checks its target against every body with one bit test.
+ */
+typedef struct {
+	Rival snakes[ARENA_SNAKES];
+	uint8_t n;							/* Snakes in this game */
+	uint8_t alive;						/* Snakes still moving */
+	uint8_t paused;						/* STOP holds every snake */
+	uint8_t winner;						/* Last snake standing or longest on a full board, else ARENA_NONE */
+	GameState state;
+	Cell food;							/* Cell of the food, shared by all snakes */
+	uint32_t used;						/* Cells covered by the bodies */
+	uint32_t seed;						/* State of the food placement generator */
+	uint64_t occupied[BOARD_WORDS];		/* Cells covered by any body */
+	uint8_t owner[CELLS];				/* Snake on a covered cell, stale on free cells */
+} Arena;
+
+/*
+ * Game logic for n snakes. Every snake steps at once on a tick, a head
+ * that runs into any body or meets another head in the same cell crashes,
+ * and crashed snakes leave the board. A game of several snakes ends when
+ * at most one is left.
+ */
+void init_arena(Arena *a, unsigned int n, uint32_t seed);
+void update_arena(Arena *a);
+void steer_arena(Arena *a, unsigned int i, Direction dir);
+
+/* Snake i as a single player snake with every other body as an obstacle, for the autopilot */
+void arena_view(const Arena *a, unsigned int i, Snake *view);
+
+#if ROWS < 32
+/* Lit LEDs of one matrix column, bit per row, the food and the snakes of a mask */
+unsigned int arena_column(const Arena *a, unsigned int col, uint32_t snakes);
+#endif
+
+/* Snake covering a cell, ARENA_NONE for a free cell */
+static inline unsigned int arena_owner(const Arena *a, unsigned int cell) {
+	return (a->occupied[cell / 64] >> (cell % 64)) & 1 ? a->owner[cell] : ARENA_NONE;
+}
+
+#endif /* ARENA_H */
@@ -0,0 +1,164 @@
+#include "autopilot.h"
+#include "hamilton.h"
+
+/* A board is two words, one byte per column, and a column shift carries across them */
+#if ROWS != 8 || COLS != 16
+#error "autopilot assumes the 16x8 matrix"
+#endif
+
+#define LOW_ROW		0x0101010101010101ull
+#define HIGH_ROW	0x8080808080808080ull
+
+unsigned int autopilot_layers;
+
+typedef struct {
+	uint64_t w[BOARD_WORDS];
+} Board;
+
+static Board cell_board(unsigned int cell) {
+	Board b = { { 0, 0 } };
+
+	b.w[cell / 64] = 1ull << (cell % 64);
+	return b;
+}
+
+static int board_empty(Board b) {
+	return !(b.w[0] | b.w[1]);
+}
+
+/* Cells next to any cell of b, the matrix wrapping around at the edges */
+static Board neighbours(Board b) {
+	Board n;
+
+	for (int i = 0; i < 2; i++) {
+		uint64_t x = b.w[i], y = b.w[1 - i];
+
+		n.w[i] = ((x << 1) & ~LOW_ROW) | ((x >> 7) & LOW_ROW)		/* row + 1 */
+			| ((x >> 1) & ~HIGH_ROW) | ((x << 7) & HIGH_ROW)		/* row - 1 */
+			| (x << 8) | (y >> 56)									/* column + 1 */
+			| (x >> 8) | (y << 56);									/* column - 1 */
+	}
+	return n;
+}
+
+/* Number of free cells reachable from a start cell */
+static unsigned int flood_area(Board start, Board free) {
+	Board seen = start, frontier = start;
+
+	while (!board_empty(frontier)) {
+		Board next = neighbours(frontier);
+
+		autopilot_layers++;
+		for (int i = 0; i < 2; i++) {
+			frontier.w[i] = next.w[i] & free.w[i] & ~seen.w[i];
+			seen.w[i] |= frontier.w[i];
+		}
+	}
+	return __builtin_popcountll(seen.w[0]) + __builtin_popcountll(seen.w[1]);
+}
+
+Direction autopilot_steer(const Snake *s) {
+	static const Direction turns[4] = { RIGHT, DOWN, UP, LEFT };
+	unsigned int head = snake_segment(s, 0);
+	Board free, step[4], seen, frontier;
+
+	autopilot_layers = 0;
+
+	/* The tail moves out of the way on the next tick */
+	for (int i = 0; i < 2; i++) {
+		free.w[i] = ~s->occupied[i];
+	}
+	free.w[snake_segment(s, s->length - 1) / 64] |= 1ull << (snake_segment(s, s->length - 1) % 64);
+
+	/* Cell each turn leads into, with the same wrap as the game */
+	for (int d = 0; d < 4; d++) {
+		Snake probe;
+
+		probe.body[0] = head;
+		probe.head = 0;
+		probe.dir = turns[d];
+		step[d] = cell_board(snake_target(&probe));
+	}
+
+	/*
+	 * Grow rings of equal distance around the food until one touches the
+	 * head, a turn into that ring is the first step of a shortest path.
+	 */
+	seen = frontier = cell_board(s->food);
+	while (!board_empty(frontier)) {
+		for (int d = 0; d < 4; d++) {
+			if (turns[d] != RIGHT + LEFT - s->moved &&
+				((frontier.w[0] & step[d].w[0]) | (frontier.w[1] & step[d].w[1]))) {
+				return turns[d];
+			}
+		}
+
+		Board next = neighbours(frontier);
+
+		autopilot_layers++;
+		for (int i = 0; i < 2; i++) {
+			frontier.w[i] = next.w[i] & free.w[i] & ~seen.w[i];
+			seen.w[i] |= frontier.w[i];
+		}
+	}
+
+	/* No way to the food, buy time in the largest free area */
+	Direction best = s->dir;
+	unsigned int most = 0;
+
+	for (int d = 0; d < 4; d++) {
+		if (turns[d] == RIGHT + LEFT - s->moved ||
+			board_empty((Board){ { step[d].w[0] & free.w[0], step[d].w[1] & free.w[1] } })) {
+			continue;
+		}
+
+		unsigned int area = flood_area(step[d], free);
+		if (area > most) {
+			most = area;
+			best = turns[d];
+		}
+	}
+	return best;
+}
+
+/* Cells ahead of a along the cycle until b */
+static unsigned int cycle_distance(unsigned int a, unsigned int b) {
+	return (hamilton_order[b] + CELLS - hamilton_order[a]) % CELLS;
+}
+
+Direction hamilton_steer(const Snake *s, int shortcuts) {
+	static const Direction turns[4] = { RIGHT, DOWN, UP, LEFT };
+	unsigned int head = snake_segment(s, 0);
+	unsigned int next = hamilton_next[head], best = 1;
+
+	/*
+	 * Every cell less than the tail distance ahead is free, the body lies
+	 * behind the head in cycle order. Shortcuts stop once the snake covers
+	 * half the board, where the detours they leave behind start to cost.
+	 */
+	if (shortcuts && s->length < CELLS / 2) {
+		unsigned int tail = cycle_distance(head, snake_segment(s, s->length - 1));
+		unsigned int food = cycle_distance(head, s->food);
+
+		for (int d = 0; d < 4; d++) {
+			Snake probe;
+			unsigned int cell, ahead;
+
+			probe.body[0] = head;
+			probe.head = 0;
+			probe.dir = turns[d];
+			cell = snake_target(&probe);
+			ahead = cycle_distance(head, cell);
+			if (ahead > best && ahead < tail && ahead <= food) {
+				best = ahead;
+				next = cell;
+			}
+		}
+	}
+
+	/* Turn toward the chosen neighbour, the matrix wraps around */
+	if (CELL_COL(next) == CELL_COL(head)) {
+		return CELL_ROW(next) == (CELL_ROW(head) + 1) % ROWS ? LEFT : RIGHT;
+	}
+	return CELL_COL(next) == (CELL_COL(head) + 1) % COLS ? DOWN : UP;
+}
@@ -0,0 +1,27 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include "snake.h"
+
+/* Flood fill steps of the last autopilot_steer() call, the unit of its running time */
+extern unsigned int autopilot_layers;
+
+/*
+ * Direction the demo snake should take next: the first step of a shortest
+ * path to the food, or the step into the largest free area when the food
+ * cannot be reached. Every search is a flood fill on the occupancy bitboard,
+ * so a call expands at most 4 * CELLS layers.
+ */
+Direction autopilot_steer(const Snake *s);
+
+/*
+ * Direction that follows the Hamiltonian cycle of hamilton.h. A snake that
+ * starts on it in cycle order, or a new game of init_snake(), never dies;
+ * a body laid out otherwise, like one taken over mid-game, may run into
+ * itself, since the steps are not checked against it. With shortcuts the head may skip
+ * ahead along the cycle as long as it stays in front of the tail and does
+ * not pass the food, which keeps the body in cycle order.
+ */
+Direction hamilton_steer(const Snake *s, int shortcuts);
+
+#endif /* AUTOPILOT_H */
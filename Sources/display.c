@@ -0,0 +1,103 @@
+#include "display.h"
+#include "viewport.h"
+
+/* Column at step i of the scan, reflected Gray code so one decoder address line changes per step of a full scan */
+#define SCAN_COLUMN(i)	((i) ^ ((i) >> 1))
+
+#if MATRIX_COLS & (MATRIX_COLS - 1)
+#error "the Gray code scan needs a power of two columns"
+#endif
+
+/* Display the snake, one matrix column at a time */
+void display_snake(const Snake *s) {
+#if WORLD_SCROLLS
+	uint8_t columns[MATRIX_COLS];
+
+	/* A larger world shows the window around the head */
+	viewport_columns(s, &viewport, columns);
+#endif
+
+	for (unsigned int i = 0; i < MATRIX_COLS; i++) {
+		unsigned int col = SCAN_COLUMN(i);
+
+		/* Blank the rows while the decoder address settles */
+		row_write(0);
+		column_select(col);
+#if WORLD_SCROLLS
+		row_write(columns[col]);
+#else
+		row_write(snake_column(s, col));
+#endif
+		delay(DISPLAY_DWELL, DISPLAY_LOOP);
+	}
+
+	/* Clear the matrix after a complete display cycle */
+	matrix_clear();
+}
+
+/*
+ * Display the frame the game tick published last. Only the lit columns are
+ * visited, in the scan order. They share the dwell of the whole matrix up
+ * to DISPLAY_BOOST times their own and the matrix stays dark for the rest,
+ * so a frame lasts as long however many columns are lit. A picture of up
+ * to MATRIX_COLS / DISPLAY_BOOST columns is that much brighter and keeps
+ * its brightness as it grows; a wider one shares the frame and dims
+ * towards the full matrix.
+ */
+void display_frame(const Frame *f) {
+	uint16_t used = f->used;
+	unsigned int lit = __builtin_popcount(used);
+	unsigned int dwell = lit ? MATRIX_COLS * DISPLAY_DWELL / lit : 0;
+	unsigned int extra = lit ? MATRIX_COLS * DISPLAY_DWELL % lit : 0;
+	unsigned int rest = 0;
+
+	if (dwell >= DISPLAY_BOOST * DISPLAY_DWELL) {
+		dwell = DISPLAY_BOOST * DISPLAY_DWELL;
+		extra = 0;
+		rest = MATRIX_COLS * DISPLAY_DWELL - lit * dwell;
+	}
+
+	for (unsigned int i = 0; i < MATRIX_COLS; i++) {
+		unsigned int col = SCAN_COLUMN(i);
+
+		if (!(used & 1u << col)) {
+			continue;
+		}
+		row_write(0);
+		column_select(col);
+		row_write(f->columns[col]);
+
+		/* The first columns take the remainder, so the dwell adds up to the full matrix */
+		delay(dwell + (extra ? 1 : 0), DISPLAY_LOOP);
+		if (extra) {
+			extra--;
+		}
+	}
+
+	/* What the lit columns left of the frame passes with the matrix dark */
+	if (rest) {
+		row_write(0);
+		delay(rest, DISPLAY_LOOP);
+	}
+
+	matrix_clear();
+}
+
+#if !WORLD_SCROLLS
+/* Display an arena, every snake but the first lit on every other frame only */
+void display_arena(const Arena *a) {
+	static unsigned int frame;
+	uint32_t snakes = frame++ & 1 ? ~0u : 1u;
+
+	for (unsigned int i = 0; i < MATRIX_COLS; i++) {
+		unsigned int col = SCAN_COLUMN(i);
+
+		row_write(0);
+		column_select(col);
+		row_write(arena_column(a, col, snakes));
+		delay(DISPLAY_DWELL, DISPLAY_LOOP);
+	}
+
+	matrix_clear();
+}
+#endif
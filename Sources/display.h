@@ -0,0 +1,30 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "arena.h"
+#include "frame.h"
+#include "snake.h"
+
+/* Pin-level matrix control, provided by main.c on the board and by the host simulator */
+void delay(int t1, int t2);
+void column_select(unsigned int col_num);
+void row_write(unsigned int rows);
+void matrix_clear(void);
+
+/* delay() loops a column is lit for on a full matrix, outer and inner; a frame lasts MATRIX_COLS of them */
+#define DISPLAY_DWELL	40
+#define DISPLAY_LOOP	50
+
+/* Most a lit column may dwell in a sparse frame, in full matrix dwells */
+#define DISPLAY_BOOST	2
+
+/* Draw one complete frame of the snake, read while it is drawn */
+void display_snake(const Snake *s);
+
+/* Draw one complete frame of what the game tick published last, its lit columns only */
+void display_frame(const Frame *f);
+
+/* Draw one complete frame of an arena, the first snake brighter than the others */
+void display_arena(const Arena *a);
+
+#endif /* DISPLAY_H */
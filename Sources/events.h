@@ -0,0 +1,46 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+
+/* Work the interrupt handlers and timers hand to the main loop, most urgent first */
+typedef enum {
+	EVENT_TICK,			/* Game tick */
+	EVENT_REFRESH,		/* Display refresh */
+	EVENTS
+} Event;
+
+/* Event e is bit 31 - e, so the count of leading zeros of the word is the most urgent pending event */
+#define EVENT_BIT(e)	(0x80000000u >> (e))
+
+/*
+ * Pending events, a bit each. Handlers set bits and the main loop clears
+ * them with atomic read-modify-writes, LDREX/STREX on the Cortex-M4 that
+ * retry when an interrupt came in between, so nothing masks interrupts. An
+ * event posted again before the main loop took it is done once.
+ */
+typedef struct {
+	volatile uint32_t pending;
+} Events;
+
+/* Post an event from a handler, returns 0 when it was pending already */
+static inline int event_post(Events *ev, Event e) {
+	return !(__atomic_fetch_or(&ev->pending, EVENT_BIT(e), __ATOMIC_SEQ_CST) & EVENT_BIT(e));
+}
+
+/* Take the most urgent pending event, EVENTS when there is none; __builtin_clz() is what __CLZ() compiles to */
+static inline Event event_take(Events *ev) {
+	uint32_t pending = ev->pending;
+	Event e;
+
+	do {
+		if (!pending) {
+			return EVENTS;
+		}
+		e = (Event)__builtin_clz(pending);
+	} while (!__atomic_compare_exchange_n(&ev->pending, &pending, pending & ~EVENT_BIT(e), 1, __ATOMIC_SEQ_CST,
+		__ATOMIC_SEQ_CST));
+	return e;
+}
+
+#endif /* EVENTS_H */
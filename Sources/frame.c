@@ -0,0 +1,24 @@
+#include "frame.h"
+
+void frame_publish(Frame *f, const Snake *s) {
+	uint16_t used = 0;
+
+#if WORLD_SCROLLS
+	viewport_columns(s, &viewport, f->columns);
+#else
+	for (unsigned int col = 0; col < MATRIX_COLS; col++) {
+		f->columns[col] = snake_column(s, col);
+	}
+#endif
+
+	for (unsigned int col = 0; col < MATRIX_COLS; col++) {
+		if (f->columns[col]) {
+			used |= 1u << col;
+		}
+	}
+	f->used = used;
+}
+
+int frame_blank(const Frame *f) {
+	return !f->used;
+}
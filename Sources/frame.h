@@ -0,0 +1,29 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>
+
+#include "snake.h"
+#include "viewport.h"
+
+#if MATRIX_COLS > 16
+#error "the column masks hold 16 columns"
+#endif
+
+/*
+ * Image of the matrix that the game tick publishes for the refresh. Both
+ * run from the main loop one after the other, so the frame has a single
+ * owner and the refresh reads it directly.
+ */
+typedef struct {
+	uint8_t columns[MATRIX_COLS];	/* Lit LEDs of every column, bit per row */
+	uint16_t used;					/* Columns with a lit LED, bit per column */
+} Frame;
+
+/* Publish the snake as the game tick left it, the window of a larger world */
+void frame_publish(Frame *f, const Snake *s);
+
+/* Whether no LED of the published frame is lit */
+int frame_blank(const Frame *f);
+
+#endif /* FRAME_H */
@@ -0,0 +1,35 @@
+#include "governor.h"
+
+void governor_init(Governor *g, uint32_t period) {
+	g->busy = 0;
+	g->period = period;
+}
+
+/* A longer refresh counts at once, a shorter one a tick at a time, so a tick of jitter does not move the period */
+void governor_refresh(Governor *g, uint32_t busy) {
+	if (busy >= g->busy) {
+		g->busy = busy;
+	} else {
+		g->busy--;
+	}
+}
+
+int governor_update(Governor *g, int moving, int lit) {
+	uint32_t period = 0;
+
+	if (lit) {
+		/* The shortest period that keeps the refresh within the load cap */
+		period = (g->busy * 100 + GOVERNOR_LOAD - 1) / GOVERNOR_LOAD;
+		if (period < 1) {
+			period = 1;
+		}
+		if (!moving && period < GOVERNOR_STILL) {
+			period = GOVERNOR_STILL;
+		}
+	}
+	if (period == g->period) {
+		return 0;
+	}
+	g->period = period;
+	return 1;
+}
@@ -0,0 +1,31 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <stdint.h>
+
+/* Share of the time the refresh may take, in percent */
+#define GOVERNOR_LOAD	90
+
+/* Refresh period of a still picture in wheel ticks, 9.73 ms or 103 Hz, just above flicker */
+#define GOVERNOR_STILL	85
+
+/*
+ * Refresh rate governor. A moving picture is refreshed as fast as the load
+ * cap allows, a still one at GOVERNOR_STILL unless the cap asks for less,
+ * and a blank one not at all. The main loop measures how long each refresh
+ * took and runs the refresh timer at the period chosen.
+ */
+typedef struct {
+	uint32_t busy;			/* Wheel ticks a refresh takes, preemption included */
+	uint32_t period;		/* Wheel ticks between refreshes, 0 while the scan is stopped */
+} Governor;
+
+void governor_init(Governor *g, uint32_t period);
+
+/* Record the duration of a refresh */
+void governor_refresh(Governor *g, uint32_t busy);
+
+/* Choose the period for the picture, returns whether it changed */
+int governor_update(Governor *g, int moving, int lit);
+
+#endif /* GOVERNOR_H */
@@ -0,0 +1,16 @@
+#ifndef HAMILTON_H
+#define HAMILTON_H
+
+#include <stdint.h>
+
+#include "snake.h"
+
+/*
+ * A Hamiltonian cycle of the matrix: hamilton_next[cell] is the cell after
+ * cell on the cycle, hamilton_order[cell] its position counted from cell 0.
+ * The tables are generated by Host/hamilton -g and checked by Host/hamilton.
+ */
+extern const uint8_t hamilton_next[CELLS];
+extern const uint8_t hamilton_order[CELLS];
+
+#endif /* HAMILTON_H */
@@ -0,0 +1,41 @@
+/* Generated by Host/hamilton -g, do not edit */
+
+#include "hamilton.h"
+
+const uint8_t hamilton_next[CELLS] = {
+	  1,   2,   3,   4,   5,   6,   7,  15,
+	 16,   8,   9,  10,  11,  12,  13,  14,
+	 17,  18,  19,  20,  21,  22,  23,  31,
+	 32,  24,  25,  26,  27,  28,  29,  30,
+	 33,  34,  35,  36,  37,  38,  39,  47,
+	 48,  40,  41,  42,  43,  44,  45,  46,
+	 49,  50,  51,  52,  53,  54,  55,  63,
+	 64,  56,  57,  58,  59,  60,  61,  62,
+	 65,  66,  67,  68,  69,  70,  71,  79,
+	 80,  72,  73,  74,  75,  76,  77,  78,
+	 81,  82,  83,  84,  85,  86,  87,  95,
+	 96,  88,  89,  90,  91,  92,  93,  94,
+	 97,  98,  99, 100, 101, 102, 103, 111,
+	112, 104, 105, 106, 107, 108, 109, 110,
+	113, 114, 115, 116, 117, 118, 119, 127,
+	  0, 120, 121, 122, 123, 124, 125, 126
+};
+
+const uint8_t hamilton_order[CELLS] = {
+	  0,   1,   2,   3,   4,   5,   6,   7,
+	 15,  14,  13,  12,  11,  10,   9,   8,
+	 16,  17,  18,  19,  20,  21,  22,  23,
+	 31,  30,  29,  28,  27,  26,  25,  24,
+	 32,  33,  34,  35,  36,  37,  38,  39,
+	 47,  46,  45,  44,  43,  42,  41,  40,
+	 48,  49,  50,  51,  52,  53,  54,  55,
+	 63,  62,  61,  60,  59,  58,  57,  56,
+	 64,  65,  66,  67,  68,  69,  70,  71,
+	 79,  78,  77,  76,  75,  74,  73,  72,
+	 80,  81,  82,  83,  84,  85,  86,  87,
+	 95,  94,  93,  92,  91,  90,  89,  88,
+	 96,  97,  98,  99, 100, 101, 102, 103,
+	111, 110, 109, 108, 107, 106, 105, 104,
+	112, 113, 114, 115, 116, 117, 118, 119,
+	127, 126, 125, 124, 123, 122, 121, 120
+};
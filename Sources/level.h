@@ -0,0 +1,18 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stdint.h>
+
+#include "snake.h"
+
+/*
+ * Levels are wall bitboards in the occupancy layout, one byte per matrix
+ * column on the 16x8 matrix, so a level is 16 bytes of flash and starting
+ * one is a copy into the occupancy bitboard (init_level). The table is
+ * generated by Host/levelc from Host/levels.txt, which rejects levels that
+ * block the start or cut off part of the free cells.
+ */
+extern const uint64_t levels[][BOARD_WORDS];
+extern const unsigned int level_count;
+
+#endif /* LEVEL_H */
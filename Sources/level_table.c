@@ -0,0 +1,16 @@
+/* Generated by Host/levelc levels.txt, do not edit */
+
+#include "level.h"
+
+#if ROWS != 8 || COLS != 16
+#error "levels were compiled for the 16x8 matrix"
+#endif
+
+const uint64_t levels[][BOARD_WORDS] = {
+	{ 0x6000000c0c000000ull, 0x0000000c0c000060ull },	/* Pillars */
+	{ 0x0000003e00000000ull, 0x000000003e000000ull },	/* Bars */
+	{ 0x7e08080800080808ull, 0x0808080008080800ull },	/* Rooms */
+	{ 0x3c18180000000000ull, 0x000000000018183cull },	/* Cross */
+};
+
+const unsigned int level_count = sizeof(levels) / sizeof(levels[0]);
@@ -3,6 +3,20 @@
 /* Header file with all the essential definitions for a given type of MCU */
 #include "MK60DZ10.h"
 
+/* Game logic and matrix refresh shared with the host tools */
+#include "snake.h"
+#include "arena.h"
+#include "display.h"
+#include "events.h"
+#include "frame.h"
+#include "governor.h"
+#include "autopilot.h"
+#include "power.h"
+#include "presses.h"
+#include "replay.h"
+#include "viewport.h"
+#include "wheel.h"
+
 /* Macros for bit-level registers manipulation */
 #define GPIO_PIN_MASK	0x1Fu
 #define GPIO_PIN(x)		(((1)<<(x & GPIO_PIN_MASK)))
@@ -18,35 +32,60 @@
 #define	tdelay1			10000
 #define tdelay2 		20
 
-/* Define the LED matrix properties */
-#define ROWS 8
-#define COLS 16
-
-/* Define the snake properties */
-#define SNAKE_LENGTH 5
-
-/* Define the direction of movement */
-typedef enum {
-	STOP,
-	RIGHT,
-	DOWN,
-	UP,
-	LEFT
-} Direction;
-
-/* Define the snake structure */
-typedef struct {
-	int body[SNAKE_LENGTH][2];	/* Array of coordinates [row, col] */
-	int length;					/* Predefined length */
-	Direction dir;				/* Current direction of movement */
-	Direction dir_before_stop;	/* Direction of movement before STOP state */
-} Snake;
+/* Periods in ticks of the timer wheel, which PIT0 turns every 4801 bus clocks or 114.5 us */
+#define GAME_TICKS		1000	/* Game tick, 114.5 ms */
+#define REFRESH_TICKS	1		/* Display refresh until the governor measured one */
+
+/* Game ticks without a button press before the demo starts, about 11 s */
+#define ATTRACT_TICKS	100
+
+/* Demo snake: 1 follows the Hamiltonian cycle from a new game, 0 has the flood fill autopilot chase the food */
+#define ATTRACT_CYCLE	1
+
+/* Walls of the game, 1 to level_count picks a level of level.h and 0 the open board */
+#define LEVEL			0
+
+/* 1 pits the player against the autopilot on one board, 0 is the single player game */
+#define VERSUS			0
 
 /* Global variable for the Snake structure */
 Snake snake;
 
+/* Board of the versus game, snake 0 is the player and snake 1 the autopilot */
+Arena arena;
+
+/* Game ticks since the last button press, the demo runs from ATTRACT_TICKS on */
+volatile unsigned int idle_ticks;
+
+/* Image of the snake the game tick publishes for the display refresh */
+Frame frame;
+
+/* Recording of the games played, read from RAM by the debugger */
+Replay replay;
+
+/* Button presses since the last game tick, which applies and records them in order */
+PressQueue presses;
+
+/* Work posted by the timer interrupts for the main loop */
+Events events;
+
+/* Timers of the periodic work, expiries that find their event still pending count as deadline misses */
+Wheel wheel;
+
+/* How long the game has stood still, which decides how deep the board sleeps */
+Power power;
+
+/* Refresh period for what the matrix shows */
+Governor governor;
+
 /* Array of pin numbers to use */
 unsigned int column_pins[4] = {8, 10, 6, 11};  // A0-A3
+
+/* PTA bits of the address of every column, the bits of a ^ b are those that differ between a and b */
+uint32_t column_address[16];
+
+/* Column the 74HC154 is addressed at */
+unsigned int column_now;
 unsigned int row_pins[8] = {26, 24, 9, 25, 28, 7, 27, 29};  // R0-R7
 unsigned int button_pins[5] = {10, 11, 12, 26, 27};  // RIGHT, STOP, DOWN, UP, LEFT
 
@@ -54,14 +93,7 @@ unsigned int button_pins[5] = {10, 11, 12, 26, 27};  // RIGHT, STOP, DOWN, UP, L
 void SystemConfig(void);
 void PIT_Init(void);
 void PIT0_IRQHandler(void);
-void PIT1_IRQHandler(void);
 void PORTE_IRQHandler(void);
-void delay(int t1, int t2);
-void column_select(unsigned int col_num);
-void row_select(unsigned int row_num);
-void init_snake(void);
-void update_snake(void);
-void display_snake(void);
 
 /* Configuration of the necessary MCU peripherals */
 void SystemConfig() {
@@ -79,6 +111,9 @@ void SystemConfig() {
 		);
 	}
 
+	/* Allow the very low power modes, PMPROT is written once after reset */
+	MC->PMPROT = MC_PMPROT_AVLP_MASK;
+
 	/* Clear any pending interrupts on Port E */
 	NVIC_ClearPendingIRQ(PORTE_IRQn);
 
@@ -96,6 +131,15 @@ void SystemConfig() {
 		PORTA->PCR[column_pins[i]] = ( 0|PORT_PCR_MUX(0x01) );
 	}
 
+	/* Address pins of every column */
+	for (int col = 0; col < 16; col++) {
+		for (int i = 0; i < 4; i++) {
+			if (col & (1 << i)) {
+				column_address[col] |= GPIO_PIN(column_pins[i]);
+			}
+		}
+	}
+
 	/* Set corresponding PTA pins (rows selectors of 74HC154) for GPIO functionality */
 	for (int i = 0; i < 8; i++) {
 		PORTA->PCR[row_pins[i]] = ( 0|PORT_PCR_MUX(0x01) );
@@ -120,81 +164,155 @@ void PIT_Init() {
 	SIM->SCGC6 |= SIM_SCGC6_PIT_MASK;
     PIT->MCR = 0x00;
 
-	/* PIT0 for game logic */
-    PIT->CHANNEL[0].LDVAL = 4800000;
+	/* PIT0 turns the timer wheel of all periodic work */
+    PIT->CHANNEL[0].LDVAL = WHEEL_LDVAL;
     PIT->CHANNEL[0].TCTRL |= PIT_TCTRL_TIE_MASK | PIT_TCTRL_TEN_MASK;
 
-	/* PIT1 for display refresh */
-	PIT->CHANNEL[1].LDVAL = 4800;
-	PIT->CHANNEL[1].TCTRL |= PIT_TCTRL_TIE_MASK | PIT_TCTRL_TEN_MASK;
-
-	/* Higher priority for game logic */
+	/* Below the buttons */
 	NVIC_SetPriority(PIT0_IRQn, 2);
 	NVIC_EnableIRQ(PIT0_IRQn);
+}
 
-	/* Lower priority for display refresh */
-	NVIC_SetPriority(PIT1_IRQn, 3);
-	NVIC_EnableIRQ(PIT1_IRQn);
+/* Game logic, run by the main loop when its timer expires */
+static void game_tick(void) {
+	/* Presses since the last tick, in the order they came */
+	Direction dir;
+	int pressed = 0;
+	while (press_take(&presses, &dir)) {
+		pressed = 1;
+#if VERSUS
+		steer_arena(&arena, 0, dir);
+#else
+		if (idle_ticks >= ATTRACT_TICKS) {
+			/* Any button ends the demo with a new game for the player */
+			record_start(&replay, &snake, snake.seed, LEVEL);
+		} else {
+			record_steer(&replay, &snake, dir, LEVEL);
+		}
+		idle_ticks = 0;
+#endif
+	}
+
+#if VERSUS
+	/* The autopilot sees the player as part of the obstacles */
+	if (arena.state == PLAYING) {
+		Snake view;
+
+		arena_view(&arena, 1, &view);
+		steer_arena(&arena, 1, autopilot_steer(&view));
+	}
+	update_arena(&arena);
+	return;
+#endif
+
+	/* A paused game waits for its player, anything else turns into the demo */
+	if (idle_ticks < ATTRACT_TICKS && snake.dir != STOP) {
+		idle_ticks++;
+
+		/* The cycle is only safe for a body laid out in its order, not the one the player left */
+		if (idle_ticks == ATTRACT_TICKS && ATTRACT_CYCLE && !snake.level) {
+			record_start(&replay, &snake, snake.seed, LEVEL);
+		}
+	}
+	if (idle_ticks >= ATTRACT_TICKS) {
+		/* The cycle runs through every cell, walls included */
+		record_steer(&replay, &snake,
+			ATTRACT_CYCLE && !snake.level ? hamilton_steer(&snake, 1) : autopilot_steer(&snake), LEVEL);
+	}
+	record_update(&replay, &snake);
+#if WORLD_SCROLLS
+	viewport_follow(&viewport, &snake);
+#endif
+	frame_publish(&frame, &snake);
+
+	/* A paused game shows the same picture until the next press */
+	power_tick(&power, !pressed && snake.state == PLAYING && snake.dir == STOP);
+}
+
+/* Display refresh, run by the main loop when its timer expires */
+static void refresh(void) {
+	uint32_t start = wheel.now;
+
+#if VERSUS
+	display_arena(&arena);
+#else
+	display_frame(&frame);
+#endif
+	governor_refresh(&governor, wheel.now - start);
 }
 
-/* Interrupt timer for game logic */
+/* Run the refresh timer at the period the governor chooses for the picture */
+static void govern(void) {
+#if VERSUS
+	int moving = arena.state == PLAYING, lit = 1;
+#else
+	int moving = snake.state == PLAYING && snake.dir != STOP;
+	int lit = !power_dark(&power) && !frame_blank(&frame);
+#endif
+	int running = governor.period != 0;
+
+	if (!governor_update(&governor, moving, lit)) {
+		return;
+	}
+
+	/* Linking and unlinking change lists of the PIT0 handler, a few stores with interrupts masked */
+	if (!governor.period) {
+		__disable_irq();
+		timer_cancel(&wheel, EVENT_REFRESH);
+		__enable_irq();
+	} else if (!running) {
+		__disable_irq();
+		timer_start(&wheel, EVENT_REFRESH, 1, governor.period);
+		__enable_irq();
+	} else {
+		timer_period(&wheel, EVENT_REFRESH, governor.period);
+	}
+}
+
+/* Interrupt timer of the wheel, expiring timers post their work for the main loop */
 void PIT0_IRQHandler() {
 	PIT->CHANNEL[0].TFLG |= PIT_TFLG_TIF_MASK;
-	update_snake();
+	wheel_tick(&wheel, &events);
 }
 
-/* Interrupt timer for display refresh */
-void PIT1_IRQHandler() {
-	PIT->CHANNEL[1].TFLG |= PIT_TFLG_TIF_MASK;
-	display_snake();
+/* Queue a button press for the next game tick, a full queue drops it */
+static void press(Direction dir) {
+	press_put(&presses, dir);
 }
 
 void PORTE_IRQHandler() {
 	/* Check if STOP button caused the interrupt */
 	if (PORTE->ISFR & BUTTON_STOP_MASK) {
 		if ( !(PTE->PDDR & BUTTON_STOP_MASK) ) {
-			if (snake.dir == STOP) {
-				snake.dir = snake.dir_before_stop;
-			} else {
-				snake.dir_before_stop = snake.dir;
-				snake.dir = STOP;
-			}
+			press(STOP);
 		}
 	}
 
 	/* Check if RIGHT button caused the interrupt */
 	if (PORTE->ISFR & BUTTON_RIGHT_MASK) {
 		if ( !(PTE->PDDR & BUTTON_RIGHT_MASK) ) {
-			if (snake.dir != LEFT && snake.dir != STOP) {
-				snake.dir = RIGHT;
-			}
+			press(RIGHT);
 		}
 	}
 
 	/* Check if DOWN button caused the interrupt */
 	if (PORTE->ISFR & BUTTON_DOWN_MASK) {
 		if ( !(PTE->PDDR & BUTTON_DOWN_MASK) ) {
-			if (snake.dir != UP && snake.dir != STOP) {
-				snake.dir = DOWN;
-			}
+			press(DOWN);
 		}
 	}
 
 	/* Check if UP button caused the interrupt */
 	if (PORTE->ISFR & BUTTON_UP_MASK) {
 		if ( !(PTE->PDDR & BUTTON_UP_MASK) ) {
-			if (snake.dir != DOWN && snake.dir != STOP) {
-				snake.dir = UP;
-			}
+			press(UP);
 		}
 	}
 
 	/* Check if LEFT button caused the interrupt */
 	if (PORTE->ISFR & BUTTON_LEFT_MASK) {
 		if ( !(PTE->PDDR & BUTTON_LEFT_MASK) ) {
-			if (snake.dir != RIGHT && snake.dir != STOP) {
-				snake.dir = LEFT;
-			}
+			press(LEFT);
 		}
 	}
 
@@ -212,134 +330,114 @@ void delay(int t1, int t2)
 	}
 }
 
-/* Conversion of requested column number into the 4-to-16 decoder control.  */
+/*
+ * Address the 4-to-16 decoder at a column. The address lines that differ
+ * from the current column toggle together in a single PTOR write, so the
+ * decoder never sees an address in between. In the Gray code scan order of
+ * display.c neighbouring steps differ in one line, so a full scan toggles
+ * one line per step; a sparse scan that skips k columns toggles at most
+ * k + 1 lines, and never more than the four.
+ */
 void column_select(unsigned int col_num)
 {
-	unsigned i, result, col_sel[4];
-
-	for (i =0; i<4; i++) {
-		result = col_num / 2;	  // Whole-number division of the input number
-		col_sel[i] = col_num % 2;
-		col_num = result;
-
-		switch(i) {
-
-			// Selection signal A0
-		    case 0:
-				((col_sel[i]) == 0) ? (PTA->PDOR &= ~GPIO_PDOR_PDO( GPIO_PIN(8))) : (PTA->PDOR |= GPIO_PDOR_PDO( GPIO_PIN(8)));
-				break;
-
-			// Selection signal A1
-			case 1:
-				((col_sel[i]) == 0) ? (PTA->PDOR &= ~GPIO_PDOR_PDO( GPIO_PIN(10))) : (PTA->PDOR |= GPIO_PDOR_PDO( GPIO_PIN(10)));
-				break;
-
-			// Selection signal A2
-			case 2:
-				((col_sel[i]) == 0) ? (PTA->PDOR &= ~GPIO_PDOR_PDO( GPIO_PIN(6))) : (PTA->PDOR |= GPIO_PDOR_PDO( GPIO_PIN(6)));
-				break;
-
-			// Selection signal A3
-			case 3:
-				((col_sel[i]) == 0) ? (PTA->PDOR &= ~GPIO_PDOR_PDO( GPIO_PIN(11))) : (PTA->PDOR |= GPIO_PDOR_PDO( GPIO_PIN(11)));
-				break;
-
-			// Otherwise nothing to do...
-			default:
-				break;
-		}
-	}
+	PTA->PTOR = GPIO_PTOR_PTTO( column_address[(col_num ^ column_now) & 0xF] );
+	column_now = col_num;
 }
 
-/* Selection of the row signal */
-void row_select(unsigned int row_num) {
-	for (int i = 0; i < 8; i++) {
-		PTA->PDOR &= ~GPIO_PDOR_PDO( GPIO_PIN(row_pins[i]) );
-	}
-
-	PTA->PDOR |= GPIO_PDOR_PDO( GPIO_PIN(row_pins[row_num]) );
-}
-
-/* Initialize the snake */
-void init_snake() {
-	snake.length = SNAKE_LENGTH;
-	snake.dir = DOWN;
-	snake.dir_before_stop = DOWN;
-
-	for (int i = 0; i < snake.length; i++) {
-        snake.body[i][0] = 0;
-        snake.body[i][1] = (snake.length - 1) - i;
-    }
-}
+/* Drive all row signals at once, bit per row */
+void row_write(unsigned int rows) {
+	unsigned int pdor = PTA->PDOR;
 
-/* Update the snake position */
-void update_snake() {
-	/* Stop the movement if STOP button is pressed */
-	if (snake.dir == STOP) {
-		return;
+	for (int i = 0; i < 8; i++) {
+		pdor &= ~GPIO_PDOR_PDO( GPIO_PIN(row_pins[i]) );
+		if (rows & (1u << i)) {
+			pdor |= GPIO_PDOR_PDO( GPIO_PIN(row_pins[i]) );
+		}
 	}
-
-	int new_head_row = snake.body[0][0];
-    int new_head_col = snake.body[0][1];
-
-    /* Calculate the new head position based on direction */
-    switch (snake.dir) {
-		case RIGHT:
-			new_head_row--;
-            break;
-		case DOWN:
-			new_head_col++;
-            break;
-        case UP:
-			new_head_col--;
-            break;
-        case LEFT:
-			new_head_row++;
-            break;
-        default:
-            break;
-    }
-
-    /* Teleport the snake if out of bounds */
-    if (new_head_row < 0) new_head_row = ROWS - 1;
-    if (new_head_row >= ROWS) new_head_row = 0;
-    if (new_head_col < 0) new_head_col = COLS - 1;
-    if (new_head_col >= COLS) new_head_col = 0;
-
-    /* Shift body positions */
-    for (int i = snake.length - 1; i > 0; i--) {
-        snake.body[i][0] = snake.body[i - 1][0];
-        snake.body[i][1] = snake.body[i - 1][1];
-    }
-
-    /* Update the new head position */
-    snake.body[0][0] = new_head_row;
-    snake.body[0][1] = new_head_col;
+	PTA->PDOR = pdor;
 }
 
-/* Display the snake */
-void display_snake() {
-	/* Draw each segment of the snake */
-    for (int i = 0; i < snake.length; i++) {
-        row_select(snake.body[i][0]);
-        column_select(snake.body[i][1]);
-        delay(250, 50);
-    }
-
-	/* Clear the matrix after a complete display cycle */
+/* Switch off all rows and column selectors */
+void matrix_clear() {
     for (int i = 0; i < 8; i++) {
         PTA->PDOR &= ~GPIO_PDOR_PDO( GPIO_PIN(row_pins[i]) );
     }
     for (int i = 0; i < 4; i++) {
         PTA->PDOR &= ~GPIO_PDOR_PDO( GPIO_PIN(column_pins[i]) );
     }
+    column_now = 0;
+}
+
+/*
+ * Stop in VLPS until a button wakes the board. The outputs keep their
+ * levels, so #EN of the 74HC154 blanks the matrix meanwhile. The PORTE pin
+ * interrupts stay armed without a clock and wake the core directly, and it
+ * returns to RUN on the clocks it had.
+ */
+static void stop(void) {
+	PTE->PDOR |= GPIO_PDOR_PDO( GPIO_PIN(28) );
+	SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+	MC->PMCTRL = MC_PMCTRL_LPLLSM(2);
+	(void)MC->PMCTRL;
+	__WFI();
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+	PTE->PDOR &= ~GPIO_PDOR_PDO( GPIO_PIN(28) );
+}
+
+/*
+ * Sleep until the next interrupt, as deep as the game allows. With
+ * interrupts masked, a handler that posts between the check and WFI still
+ * wakes the core, and runs once they are unmasked again.
+ */
+static void idle(void) {
+	__disable_irq();
+	switch (power_mode(&power, events.pending, presses.in - presses.out)) {
+		case POWER_WAIT:
+			__WFI();
+			break;
+		case POWER_STOP:
+			stop();
+			break;
+		default:
+			break;
+	}
+	__enable_irq();
 }
 
 /* Main function */
 int main(void)
 {
+	record_init(&replay);
+	record_start(&replay, &snake, 1, LEVEL);
+	frame_publish(&frame, &snake);
+#if VERSUS
+	init_arena(&arena, 2, 1);
+#endif
+
+	power_init(&power);
+	governor_init(&governor, REFRESH_TICKS);
+
+	/* The timers start before PIT0 runs, govern() masks it for later changes */
+	wheel_init(&wheel);
+	timer_start(&wheel, EVENT_TICK, GAME_TICKS, GAME_TICKS);
+	timer_start(&wheel, EVENT_REFRESH, REFRESH_TICKS, REFRESH_TICKS);
 	SystemConfig();
-	init_snake();
-    while(1);
-    return 0;
+
+	/* Do the posted work, the game tick before the refresh, and sleep when there is none */
+	while (1) {
+		switch (event_take(&events)) {
+			case EVENT_TICK:
+				game_tick();
+				govern();
+				break;
+			case EVENT_REFRESH:
+				refresh();
+				govern();
+				break;
+			default:
+				idle();
+				break;
+		}
+	}
+	return 0;
 }
@@ -0,0 +1,29 @@
+#include "power.h"
+
+void power_init(Power *p) {
+	p->still = 0;
+}
+
+void power_tick(Power *p, int still) {
+	if (!still) {
+		p->still = 0;
+	} else if (p->still < POWER_LINGER) {
+		p->still++;
+	}
+}
+
+int power_dark(const Power *p) {
+	return p->still >= POWER_LINGER;
+}
+
+PowerMode power_mode(const Power *p, uint32_t pending, unsigned int presses) {
+	if (pending) {
+		return POWER_RUN;
+	}
+
+	/* A press waiting for its game tick has to find the wheel turning */
+	if (presses || !power_dark(p)) {
+		return POWER_WAIT;
+	}
+	return POWER_STOP;
+}
@@ -0,0 +1,37 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+/* Game ticks a paused game stays on the display before the board stops, about 5 s */
+#define POWER_LINGER	44
+
+/* How the main loop waits when it has taken every event */
+typedef enum {
+	POWER_RUN,		/* Work came in meanwhile, do not sleep */
+	POWER_WAIT,		/* WFI, the timer wheel keeps turning */
+	POWER_STOP		/* VLPS with the display blanked, the PIT stops and only a button wakes the board */
+} PowerMode;
+
+/*
+ * Power state of the board, kept by the game tick. Nothing on the display
+ * changes while the game is paused, so once it has been paused for
+ * POWER_LINGER ticks the refresh leaves the matrix dark and the board stops
+ * until the next press.
+ */
+typedef struct {
+	unsigned int still;			/* Game ticks in a row the game was paused and no press came */
+} Power;
+
+void power_init(Power *p);
+
+/* Called by every game tick with whether the game was paused and took no press */
+void power_tick(Power *p, int still);
+
+/* Whether the refresh leaves the matrix dark */
+int power_dark(const Power *p);
+
+/* Mode to wait in with the events and presses pending, decided with interrupts masked */
+PowerMode power_mode(const Power *p, uint32_t pending, unsigned int presses);
+
+#endif /* POWER_H */
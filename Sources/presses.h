@@ -0,0 +1,51 @@
+#ifndef PRESSES_H
+#define PRESSES_H
+
+#include <stdint.h>
+
+#include "race.h"
+#include "snake.h"
+
+/* Presses held between two game ticks, a power of two */
+#define PRESS_QUEUE 8
+
+/*
+ * Button presses from PORTE_IRQHandler() to the game tick. The button
+ * handler only writes in and the slot it is about to cover, the game tick
+ * only out, so neither side masks interrupts. The button handler has the
+ * higher priority and is never preempted by the game tick.
+ */
+typedef struct {
+	volatile uint8_t dir[PRESS_QUEUE];
+	volatile unsigned int in, out;
+} PressQueue;
+
+/* Queue a press for the next game tick, a full queue drops it and returns 0 */
+static inline int press_put(PressQueue *q, Direction dir) {
+	unsigned int in = q->in;
+
+	if (in - q->out >= PRESS_QUEUE) {
+		return 0;
+	}
+	q->dir[in % PRESS_QUEUE] = dir;
+	/* The slot is written before the game tick can see it */
+	q->in = in + 1;
+	return 1;
+}
+
+/* Take the oldest press, returns 0 when there is none */
+static inline int press_take(PressQueue *q, Direction *dir) {
+	unsigned int out = q->out;
+
+	RACE_POINT();
+	if (out == q->in) {
+		return 0;
+	}
+	RACE_POINT();
+	*dir = (Direction)q->dir[out % PRESS_QUEUE];
+	RACE_POINT();
+	q->out = out + 1;
+	return 1;
+}
+
+#endif /* PRESSES_H */
@@ -0,0 +1,16 @@
+#ifndef RACE_H
+#define RACE_H
+
+/*
+ * Point between two accesses to memory that a higher priority handler
+ * shares. The board leaves it out; the host race explorer builds with
+ * RACE_POINTS and runs the higher priority handler there.
+ */
+#ifdef RACE_POINTS
+void race_point(void);
+#define RACE_POINT() race_point()
+#else
+#define RACE_POINT()
+#endif
+
+#endif /* RACE_H */
@@ -0,0 +1,115 @@
+#include "level.h"
+#include "replay.h"
+
+static unsigned int put_varint(uint8_t *p, uint64_t x) {
+	unsigned int n = 0;
+
+	while (x >= 0x80) {
+		p[n++] = (uint8_t)x | 0x80;
+		x >>= 7;
+	}
+	p[n++] = (uint8_t)x;
+	return n;
+}
+
+/* Copy a whole record into the ring, or count it as dropped when the reader is behind */
+static int emit(Replay *r, const uint8_t *p, unsigned int n) {
+	uint32_t w = r->written;
+
+	if (REPLAY_BYTES - (w - r->read) < n) {
+		r->dropped++;
+		return 0;
+	}
+	for (unsigned int i = 0; i < n; i++) {
+		r->data[(w + i) % REPLAY_BYTES] = p[i];
+	}
+	/* The reader sees the record once written covers it */
+	r->written = w + n;
+	return 1;
+}
+
+/* Record header, ticks since the last record and the code */
+static unsigned int record(const Replay *r, uint8_t *p, unsigned int code) {
+	return put_varint(p, (uint64_t)(r->tick - r->last) << 3 | code);
+}
+
+/* Emit a record, the next one counts its ticks from here only when this one was written */
+static void emit_record(Replay *r, const uint8_t *p, unsigned int n) {
+	if (emit(r, p, n)) {
+		r->last = r->tick;
+	}
+}
+
+void record_init(Replay *r) {
+	static const char magic[8] = "SNKREPLY";
+	const uint8_t header[7] = { 'S', 'N', 'K', 'R', REPLAY_VERSION, COLS, ROWS };
+
+	for (int i = 0; i < 8; i++) {
+		r->magic[i] = magic[i];
+	}
+	r->written = 0;
+	r->read = 0;
+	r->dropped = 0;
+	r->tick = 0;
+	r->last = 0;
+	emit(r, header, sizeof(header));
+}
+
+void record_start(Replay *r, Snake *s, uint32_t seed, unsigned int level) {
+	uint8_t p[REPLAY_RECORD_MAX];
+	unsigned int n = record(r, p, REPLAY_START);
+
+	n += put_varint(p + n, seed);
+	p[n++] = level;
+	emit_record(r, p, n);
+	init_level(s, seed, level ? levels[level - 1] : NULL);
+}
+
+/* Presses that change nothing are left out, so a demo only records its turns */
+void record_steer(Replay *r, Snake *s, Direction dir, unsigned int level) {
+	uint8_t p[REPLAY_RECORD_MAX];
+
+	/* A press after the end of a game starts the next one, recorded as a start */
+	if (s->state != PLAYING) {
+		record_start(r, s, s->seed, level);
+		return;
+	}
+	if (dir == STOP || (dir != s->dir && s->dir != STOP)) {
+		emit_record(r, p, record(r, p, dir));
+		steer_snake(s, dir);
+	}
+}
+
+void record_update(Replay *r, Snake *s) {
+	GameState state = s->state;
+
+	update_snake(s);
+	r->tick++;
+
+	/* The hash of the final state lets the replay check it took the same course */
+	if (state == PLAYING && s->state != PLAYING) {
+		uint8_t p[REPLAY_RECORD_MAX];
+		uint32_t hash = snake_hash(s);
+		unsigned int n = record(r, p, REPLAY_END);
+
+		for (int i = 0; i < 4; i++) {
+			p[n++] = hash >> (i * 8);
+		}
+		emit_record(r, p, n);
+	}
+}
+
+uint32_t snake_hash(const Snake *s) {
+	uint32_t h = 2166136261u;
+	uint32_t fields[8] = { s->length, s->food, s->state, s->dir, s->dir_before_stop, s->moved, s->seed, s->walls };
+
+#define MIX(x) (h = (h ^ (uint32_t)(x)) * 16777619u)
+	for (int i = 0; i < 8; i++) {
+		MIX(fields[i]);
+	}
+	for (unsigned int i = 0; i < s->length; i++) {
+		MIX(snake_segment(s, i));
+	}
+#undef MIX
+	return h;
+}
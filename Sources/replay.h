@@ -0,0 +1,58 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+
+#include "snake.h"
+
+/* Bytes of the recording ring in RAM */
+#ifndef REPLAY_BYTES
+#define REPLAY_BYTES 1024
+#endif
+
+#if REPLAY_BYTES & (REPLAY_BYTES - 1)
+#error "the ring size must be a power of two"
+#endif
+
+/*
+ * A recording is a byte stream: the header "SNKR", the format version and
+ * the board size in columns and rows, then one record per engine call
+ * that changed the game. A record starts with the varint
+ * ticks since the last record << 3 | code, where the code is a Direction
+ * for a press or one of these.
+ */
+#define REPLAY_VERSION	1
+#define REPLAY_START	5	/* init_level(), followed by the varint seed and the level number */
+#define REPLAY_END		6	/* The game ended, followed by the 4 byte snake_hash() of the state */
+
+/* Longest record: a start with a 35 bit varint and a 32 bit seed, and the level */
+#define REPLAY_RECORD_MAX 11
+
+/*
+ * Recorder of the games played on the board. The game tick writes the
+ * stream into the ring and the debugger reads it from RAM while the board
+ * runs, found by the magic string, advancing read as it takes bytes.
+ * Records that do not fit are counted in dropped instead of written.
+ */
+typedef struct {
+	char magic[8];						/* "SNKREPLY" */
+	volatile uint32_t written;			/* Bytes written by the game tick */
+	volatile uint32_t read;				/* Bytes taken by the reader */
+	volatile uint32_t dropped;			/* Records lost to a full ring */
+	uint32_t tick;						/* Game ticks since the recording began */
+	uint32_t last;						/* Tick of the last record */
+	volatile uint8_t data[REPLAY_BYTES];
+} Replay;
+
+/* Start a recording with its header */
+void record_init(Replay *r);
+
+/* The engine calls of the game tick, made and recorded; level is the number of the level, 0 for none */
+void record_start(Replay *r, Snake *s, uint32_t seed, unsigned int level);
+void record_steer(Replay *r, Snake *s, Direction dir, unsigned int level);
+void record_update(Replay *r, Snake *s);
+
+/* FNV-1a hash over the words of everything that decides how a game goes on */
+uint32_t snake_hash(const Snake *s);
+
+#endif /* REPLAY_H */
@@ -0,0 +1,234 @@
+#include "snake.h"
+
+uint32_t next_random(uint32_t *seed) {
+	uint32_t x = *seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *seed = x;
+}
+
+static void set_cell(Snake *s, unsigned int cell) {
+	s->occupied[cell / 64] |= 1ull << (cell % 64);
+}
+
+static void clear_cell(Snake *s, unsigned int cell) {
+	s->occupied[cell / 64] &= ~(1ull << (cell % 64));
+}
+
+unsigned int board_free_cell(const uint64_t occupied[BOARD_WORDS], unsigned int n) {
+	for (unsigned int w = 0; w < BOARD_WORDS; w++) {
+		uint64_t free = ~occupied[w];
+
+		if (w == BOARD_WORDS - 1 && CELLS % 64) {
+			free &= (1ull << (CELLS % 64)) - 1;
+		}
+
+		unsigned int count = __builtin_popcountll(free);
+		if (n < count) {
+			/* Drop the n lowest free cells */
+			while (n--) {
+				free &= free - 1;
+			}
+			return w * 64 + __builtin_ctzll(free);
+		}
+		n -= count;
+	}
+	return CELLS;
+}
+
+/* Put the food on a random free cell */
+void place_food(Snake *s) {
+	s->food = board_free_cell(s->occupied, next_random(&s->seed) % (CELLS - s->length - s->walls));
+}
+
+/* Initialize the snake on an open board */
+void init_snake(Snake *s, uint32_t seed) {
+	init_level(s, seed, NULL);
+}
+
+/* Initialize the snake among the walls of a level, which keeps the start row free */
+void init_level(Snake *s, uint32_t seed, const uint64_t level[BOARD_WORDS]) {
+	s->length = SNAKE_LENGTH;
+	s->head = SNAKE_LENGTH - 1;
+	s->state = PLAYING;
+	s->dir = DOWN;
+	s->dir_before_stop = DOWN;
+	s->moved = DOWN;
+	s->seed = seed ? seed : 1;
+	s->level = level;
+	s->walls = 0;
+
+	/* The walls are in the occupancy layout already, loading them is a copy */
+	for (int w = 0; w < BOARD_WORDS; w++) {
+		s->occupied[w] = level ? level[w] : 0;
+		s->walls += level ? __builtin_popcountll(level[w]) : 0;
+	}
+
+	/* Lay the body along row 0 with the head in column length - 1 */
+	for (unsigned int i = 0; i < s->length; i++) {
+		s->body[i] = CELL(0, i);
+		set_cell(s, s->body[i]);
+	}
+
+	place_food(s);
+}
+
+unsigned int snake_segment(const Snake *s, unsigned int i) {
+	return s->body[(s->head + SNAKE_MAX_LENGTH - i) % SNAKE_MAX_LENGTH];
+}
+
+unsigned int cell_step(unsigned int cell, Direction dir) {
+	int new_head_row = CELL_ROW(cell);
+	int new_head_col = CELL_COL(cell);
+
+    /* Calculate the new head position based on direction */
+    switch (dir) {
+		case RIGHT:
+			new_head_row--;
+            break;
+		case DOWN:
+			new_head_col++;
+            break;
+        case UP:
+			new_head_col--;
+            break;
+        case LEFT:
+			new_head_row++;
+            break;
+        default:
+            break;
+    }
+
+#if SNAKE_WALLS
+	if (new_head_row < 0 || new_head_row >= ROWS || new_head_col < 0 || new_head_col >= COLS) {
+		return CELLS;
+	}
+#endif
+
+    /* Teleport the snake if out of bounds */
+    if (new_head_row < 0) new_head_row = ROWS - 1;
+    if (new_head_row >= ROWS) new_head_row = 0;
+    if (new_head_col < 0) new_head_col = COLS - 1;
+    if (new_head_col >= COLS) new_head_col = 0;
+
+	return CELL(new_head_row, new_head_col);
+}
+
+unsigned int snake_target(const Snake *s) {
+	return cell_step(s->body[s->head], s->dir);
+}
+
+/* Update the snake position */
+void update_snake(Snake *s) {
+	/* Stop the movement if STOP button is pressed or the game has ended */
+	if (s->dir == STOP || s->state != PLAYING) {
+		return;
+	}
+
+	unsigned int target = snake_target(s);
+	unsigned int tail = snake_segment(s, s->length - 1);
+	int grow = target == s->food;
+
+#if SNAKE_WALLS
+	if (target == CELLS) {
+		s->state = GAME_OVER;
+		return;
+	}
+#endif
+
+	/* The tail moves out of the way unless the snake eats */
+	if (!grow) {
+		clear_cell(s, tail);
+	}
+
+	if (snake_occupies(s, target)) {
+		if (!grow) {
+			set_cell(s, tail);
+		}
+		s->state = GAME_OVER;
+		return;
+	}
+
+	/* Advance the head, the ring buffer drops the old tail by itself */
+	s->head = (s->head + 1) % SNAKE_MAX_LENGTH;
+	s->body[s->head] = target;
+	set_cell(s, target);
+	s->moved = s->dir;
+
+	if (grow) {
+		s->length++;
+		if (!snake_has_food(s)) {
+			s->state = GAME_WON;
+		} else {
+			place_food(s);
+		}
+	}
+}
+
+#if ROWS < 32
+unsigned int board_column(const uint64_t occupied[BOARD_WORDS], unsigned int col) {
+	unsigned int bit = col * ROWS;
+	uint64_t bits = occupied[bit / 64] >> (bit % 64);
+
+	/* A column may straddle two words when ROWS does not divide 64 */
+	if (bit % 64 + ROWS > 64 && bit / 64 + 1 < BOARD_WORDS) {
+		bits |= occupied[bit / 64 + 1] << (64 - bit % 64);
+	}
+	return bits & ((1u << ROWS) - 1);
+}
+
+unsigned int snake_column(const Snake *s, unsigned int col) {
+	unsigned int bits = board_column(s->occupied, col);
+
+	if (snake_has_food(s) && CELL_COL(s->food) == col) {
+		bits |= 1u << CELL_ROW(s->food);
+	}
+	return bits;
+}
+#endif
+
+/*
+ * React to a button press. Turns are checked against the direction of the
+ * last step rather than the requested one, so two presses within one game
+ * tick cannot reverse the snake into its own neck.
+ */
+void steer_snake(Snake *s, Direction dir) {
+	/* Any button starts a new game once the last one has ended */
+	if (s->state != PLAYING) {
+		init_level(s, s->seed, s->level);
+		return;
+	}
+
+	switch (dir) {
+		case STOP:
+			if (s->dir == STOP) {
+				s->dir = s->dir_before_stop;
+			} else {
+				s->dir_before_stop = s->dir;
+				s->dir = STOP;
+			}
+			break;
+		case RIGHT:
+			if (s->moved != LEFT && s->dir != STOP) {
+				s->dir = RIGHT;
+			}
+			break;
+		case DOWN:
+			if (s->moved != UP && s->dir != STOP) {
+				s->dir = DOWN;
+			}
+			break;
+		case UP:
+			if (s->moved != DOWN && s->dir != STOP) {
+				s->dir = UP;
+			}
+			break;
+		case LEFT:
+			if (s->moved != RIGHT && s->dir != STOP) {
+				s->dir = LEFT;
+			}
+			break;
+	}
+}
@@ -0,0 +1,133 @@
+#ifndef SNAKE_H
+#define SNAKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Define the LED matrix properties. Host tools build the engine for other
+ * boards by defining these on the command line, the types and widths below
+ * follow at compile time.
+ */
+#ifndef ROWS
+#define ROWS 8
+#endif
+#ifndef COLS
+#define COLS 16
+#endif
+#define CELLS (ROWS * COLS)
+
+/* Define the snake properties */
+#ifndef SNAKE_LENGTH
+#define SNAKE_LENGTH 5			/* Length at the start of a game */
+#endif
+#ifndef SNAKE_MAX_LENGTH
+#define SNAKE_MAX_LENGTH CELLS	/* The game is won at this length */
+#endif
+
+/* 1 ends the game at the edges of the matrix, 0 wraps the snake around */
+#ifndef SNAKE_WALLS
+#define SNAKE_WALLS 0
+#endif
+
+#if SNAKE_LENGTH > COLS || SNAKE_MAX_LENGTH > CELLS || SNAKE_MAX_LENGTH <= SNAKE_LENGTH
+#error "the starting snake must fit in row 0 and the maximum length on the board"
+#endif
+
+/* Smallest types for a cell number and for a length, bytes on the 16x8 matrix */
+#if CELLS <= 256
+typedef uint8_t Cell;
+#elif CELLS <= 65536
+typedef uint16_t Cell;
+#else
+typedef uint32_t Cell;
+#endif
+#if SNAKE_MAX_LENGTH <= 255
+typedef uint8_t Length;
+#elif SNAKE_MAX_LENGTH <= 65535
+typedef uint16_t Length;
+#else
+typedef uint32_t Length;
+#endif
+
+/* Cells are numbered column by column, so one matrix column is ROWS consecutive bits */
+#define CELL(row, col)	((col) * ROWS + (row))
+#define CELL_ROW(cell)	((cell) % ROWS)
+#define CELL_COL(cell)	((cell) / ROWS)
+
+/* Words of an occupancy bitboard, bit CELL(row, col) set for a cell in use */
+#define BOARD_WORDS ((CELLS + 63) / 64)
+
+/* Define the direction of movement */
+typedef enum {
+	STOP,
+	RIGHT,
+	DOWN,
+	UP,
+	LEFT
+} Direction;
+
+/* Define the state of a game */
+typedef enum {
+	PLAYING,
+	GAME_OVER,	/* The head ran into the body */
+	GAME_WON	/* The snake fills the whole matrix */
+} GameState;
+
+/* Define the snake structure */
+typedef struct {
+	Cell body[SNAKE_MAX_LENGTH];		/* Ring buffer of cells, body[head] is the head */
+	Length head;						/* Ring buffer index of the head */
+	Length length;						/* Current number of segments */
+	Cell food;							/* Cell of the food */
+	GameState state;
+	Direction dir;						/* Current direction of movement */
+	Direction dir_before_stop;			/* Direction of movement before STOP state */
+	Direction moved;					/* Direction of the last step taken */
+	uint32_t seed;						/* State of the food placement generator */
+	const uint64_t *level;				/* Wall bitboard of the level, NULL for an open board */
+	Cell walls;							/* Number of wall cells in the level */
+	uint64_t occupied[BOARD_WORDS];		/* Cells covered by the body or a wall */
+} Snake;
+
+/* Game logic, shared by the firmware and the host tools */
+void init_snake(Snake *s, uint32_t seed);
+void init_level(Snake *s, uint32_t seed, const uint64_t level[BOARD_WORDS]);
+void update_snake(Snake *s);
+void steer_snake(Snake *s, Direction dir);
+void place_food(Snake *s);
+
+/* Cell of segment i, 0 being the head */
+unsigned int snake_segment(const Snake *s, unsigned int i);
+
+/* Cell the head moves into on the next step, CELLS when that is through a wall */
+unsigned int snake_target(const Snake *s);
+
+/* Cell one step from a cell in a direction, CELLS when that is through a wall */
+unsigned int cell_step(unsigned int cell, Direction dir);
+
+/* Next value of the food placement generator (xorshift32), kept in seed */
+uint32_t next_random(uint32_t *seed);
+
+/* The n-th free cell of an occupancy bitboard counting from cell 0, CELLS past the last */
+unsigned int board_free_cell(const uint64_t occupied[BOARD_WORDS], unsigned int n);
+
+#if ROWS < 32
+/* Cells in use of one matrix column of an occupancy bitboard, bit per row */
+unsigned int board_column(const uint64_t occupied[BOARD_WORDS], unsigned int col);
+
+/* Lit LEDs of one matrix column, bit per row, body and food */
+unsigned int snake_column(const Snake *s, unsigned int col);
+#endif
+
+/* Whether a cell is covered by the body or a wall */
+static inline int snake_occupies(const Snake *s, unsigned int cell) {
+	return (s->occupied[cell / 64] >> (cell % 64)) & 1;
+}
+
+/* Whether there is food on the board, there is none once the snake fills the free cells */
+static inline int snake_has_food(const Snake *s) {
+	return s->length < SNAKE_MAX_LENGTH && s->length + s->walls < CELLS;
+}
+
+#endif /* SNAKE_H */
@@ -0,0 +1,71 @@
+#include "viewport.h"
+
+Viewport viewport;
+
+/* New window origin along one axis of the world, n cells long with a window of size cells */
+static unsigned int follow_axis(unsigned int origin, unsigned int head, unsigned int n, unsigned int size,
+	unsigned int margin) {
+#if SNAKE_WALLS
+	/* Without wrapping the window stops at the walls */
+	if (head < origin + margin) {
+		origin = head > margin ? head - margin : 0;
+	} else if (head + margin + 1 > origin + size) {
+		origin = head + margin + 1 - size;
+	}
+	return origin > n - size ? n - size : origin;
+#else
+	unsigned int offset = (head + n - origin) % n;
+
+	if (offset < margin) {
+		origin = (head + n - margin) % n;
+	} else if (offset + margin + 1 > size) {
+		origin = (head + margin + 1 + n - size) % n;
+	}
+	return origin;
+#endif
+}
+
+void viewport_follow(Viewport *v, const Snake *s) {
+	unsigned int head = snake_segment(s, 0);
+
+	v->row = follow_axis(v->row, CELL_ROW(head), ROWS, MATRIX_ROWS, VIEWPORT_ROW_MARGIN);
+	v->col = follow_axis(v->col, CELL_COL(head), COLS, MATRIX_COLS, VIEWPORT_COL_MARGIN);
+}
+
+/* Eight bits of the bitboard from bit pos on, which may straddle two words */
+static unsigned int bits_at(const uint64_t *board, unsigned int pos) {
+	unsigned int w = pos / 64, o = pos % 64;
+	uint64_t bits = board[w] >> o;
+
+	if (o > 64 - MATRIX_ROWS && w + 1 < BOARD_WORDS) {
+		bits |= board[w + 1] << (64 - o);
+	}
+	return bits & ((1u << MATRIX_ROWS) - 1);
+}
+
+/*
+ * A world column is ROWS consecutive bits, so the window rows of a column
+ * are one funnel shift, or two when the window wraps past the last row.
+ */
+void viewport_columns(const Snake *s, const Viewport *v, uint8_t columns[MATRIX_COLS]) {
+	unsigned int wrap = ROWS - v->row;
+
+	for (unsigned int c = 0; c < MATRIX_COLS; c++) {
+		unsigned int base = (v->col + c) % COLS * ROWS;
+		unsigned int bits = bits_at(s->occupied, base + v->row);
+
+		if (wrap < MATRIX_ROWS) {
+			bits = (bits & ((1u << wrap) - 1)) | (bits_at(s->occupied, base) << wrap);
+		}
+		columns[c] = bits;
+	}
+
+	if (snake_has_food(s)) {
+		unsigned int row = (CELL_ROW(s->food) + ROWS - v->row) % ROWS;
+		unsigned int col = (CELL_COL(s->food) + COLS - v->col) % COLS;
+
+		if (row < MATRIX_ROWS && col < MATRIX_COLS) {
+			columns[col] |= 1u << row;
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef VIEWPORT_H
+#define VIEWPORT_H
+
+#include <stdint.h>
+
+#include "snake.h"
+
+/* Define the physical LED matrix, the world of the game may be larger */
+#define MATRIX_ROWS 8
+#define MATRIX_COLS 16
+
+/* Whether the matrix shows a scrolling window of a larger world */
+#define WORLD_SCROLLS (ROWS != MATRIX_ROWS || COLS != MATRIX_COLS)
+
+#if ROWS < MATRIX_ROWS || COLS < MATRIX_COLS
+#error "the world must cover the whole matrix"
+#endif
+
+/* Cells of the world between the head and the edges of the window it scrolls at */
+#define VIEWPORT_ROW_MARGIN 2
+#define VIEWPORT_COL_MARGIN 4
+
+/* World cell shown in the top left corner of the matrix */
+typedef struct {
+	unsigned int row;
+	unsigned int col;
+} Viewport;
+
+/* Window shown by display_snake() */
+extern Viewport viewport;
+
+/* Scroll the window as little as needed to keep the head inside the margins */
+void viewport_follow(Viewport *v, const Snake *s);
+
+/* Lit LEDs of every matrix column, bit per row, body and food in the window */
+void viewport_columns(const Snake *s, const Viewport *v, uint8_t columns[MATRIX_COLS]);
+
+#endif /* VIEWPORT_H */
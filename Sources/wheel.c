@@ -0,0 +1,109 @@
+#include "wheel.h"
+
+void wheel_init(Wheel *w) {
+	w->now = 0;
+	w->expired = 0;
+	w->misses = 0;
+	for (unsigned int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++) {
+		w->head[i] = WHEEL_NONE;
+	}
+	for (int e = 0; e < EVENTS; e++) {
+		w->timer[e].running = 0;
+		w->timer[e].misses = 0;
+	}
+}
+
+/* Link a timer into the slot of the lowest level whose span reaches its tick */
+static void link(Wheel *w, unsigned int id) {
+	Timer *t = &w->timer[id];
+	uint32_t delta = t->expires - w->now;
+	int level = 0;
+
+	while (level < WHEEL_LEVELS - 1 && delta >= 1u << (WHEEL_BITS * (level + 1))) {
+		level++;
+	}
+
+	t->slot = level * WHEEL_SLOTS + ((t->expires >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+	t->prev = WHEEL_NONE;
+	t->next = w->head[t->slot];
+	if (t->next != WHEEL_NONE) {
+		w->timer[t->next].prev = id;
+	}
+	w->head[t->slot] = id;
+	t->running = 1;
+}
+
+static void unlink(Wheel *w, unsigned int id) {
+	Timer *t = &w->timer[id];
+
+	if (t->prev != WHEEL_NONE) {
+		w->timer[t->prev].next = t->next;
+	} else {
+		w->head[t->slot] = t->next;
+	}
+	if (t->next != WHEEL_NONE) {
+		w->timer[t->next].prev = t->prev;
+	}
+	t->running = 0;
+}
+
+void timer_start(Wheel *w, Event e, uint32_t delay, uint32_t period) {
+	Timer *t = &w->timer[e];
+
+	if (t->running) {
+		unlink(w, e);
+	}
+	if (delay < 1) {
+		delay = 1;
+	}
+	if (delay > WHEEL_MAX) {
+		delay = WHEEL_MAX;
+	}
+	t->expires = w->now + delay;
+	t->period = period > WHEEL_MAX ? WHEEL_MAX : period;
+	link(w, e);
+}
+
+void timer_period(Wheel *w, Event e, uint32_t period) {
+	w->timer[e].period = period > WHEEL_MAX ? WHEEL_MAX : period;
+}
+
+void timer_cancel(Wheel *w, Event e) {
+	if (w->timer[e].running) {
+		unlink(w, e);
+	}
+}
+
+void wheel_tick(Wheel *w, Events *events) {
+	uint8_t id;
+
+	w->now++;
+
+	/* Where a level wraps around, the next slot of the level above moves down */
+	for (int level = 1; level < WHEEL_LEVELS; level++) {
+		if (w->now & ((1u << (WHEEL_BITS * level)) - 1)) {
+			break;
+		}
+
+		unsigned int slot = level * WHEEL_SLOTS + ((w->now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+		while ((id = w->head[slot]) != WHEEL_NONE) {
+			unlink(w, id);
+			link(w, id);
+		}
+	}
+
+	while ((id = w->head[w->now & (WHEEL_SLOTS - 1)]) != WHEEL_NONE) {
+		Timer *t = &w->timer[id];
+
+		unlink(w, id);
+		w->expired++;
+		if (!event_post(events, (Event)id)) {
+			t->misses++;
+			w->misses++;
+		}
+		if (t->period) {
+			t->expires += t->period;
+			link(w, id);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef WHEEL_H
+#define WHEEL_H
+
+#include <stdint.h>
+
+#include "events.h"
+
+/* Levels of the wheel and slots per level, a timer reaches 2^24 ticks ahead */
+#define WHEEL_LEVELS	4
+#define WHEEL_BITS		6
+#define WHEEL_SLOTS		(1u << WHEEL_BITS)
+#define WHEEL_MAX		((1ul << (WHEEL_LEVELS * WHEEL_BITS)) - 1)
+
+/* PIT0 reload value of one wheel tick, 4801 bus clocks or 114.5 us at 41.94 MHz */
+#define WHEEL_LDVAL		4800
+
+/* End of a slot list */
+#define WHEEL_NONE		0xFF
+
+/* The timer of each event, which posts it when it expires */
+typedef struct {
+	uint32_t expires;				/* Wheel tick it is due at */
+	uint32_t period;				/* Ticks to the next expiry, 0 for a one-shot */
+	uint32_t misses;				/* Expiries that found the last one still pending, deadline misses */
+	uint8_t next, prev;				/* Slot list, WHEEL_NONE at its ends */
+	uint8_t slot;					/* Level * WHEEL_SLOTS + slot it is linked into */
+	uint8_t running;
+} Timer;
+
+/*
+ * Hierarchical timer wheel turned by one PIT channel. Level 0 has a slot
+ * for each of the next WHEEL_SLOTS ticks; a slot of a higher level covers
+ * WHEEL_SLOTS slots of the level below and is spread over them when the
+ * wheel gets there. Starting and cancelling a timer links or unlinks it
+ * from one slot, and a tick expires one slot, so every operation takes
+ * constant time; a timer moves down at most WHEEL_LEVELS - 1 times. The
+ * lists link timers by index rather than by pointer, so the wheel can be
+ * copied as it is.
+ */
+typedef struct {
+	volatile uint32_t now;						/* Ticks since wheel_init() */
+	uint8_t head[WHEEL_LEVELS * WHEEL_SLOTS];	/* First timer of each slot */
+	Timer timer[EVENTS];
+	uint32_t expired;							/* Expiries of all timers */
+	uint32_t misses;							/* Misses of all timers */
+} Wheel;
+
+void wheel_init(Wheel *w);
+
+/* Start or restart the timer of an event delay ticks from now, at least 1, then every period ticks */
+void timer_start(Wheel *w, Event e, uint32_t delay, uint32_t period);
+
+/* Change the period of a running timer from its next expiry on, a single store the PIT handler reads once */
+void timer_period(Wheel *w, Event e, uint32_t period);
+
+/* Stop the timer of an event, stopping a stopped one does nothing */
+void timer_cancel(Wheel *w, Event e);
+
+/* Advance the wheel by one tick and post the events of the timers that expire, called by the PIT handler */
+void wheel_tick(Wheel *w, Events *events);
+
+#endif /* WHEEL_H */